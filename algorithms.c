@@ -6,6 +6,330 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/*
+ * Préchargement d'une ligne de cache quand le compilateur le permet
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr) ((void)(addr))
+#endif
+
+/*
+ * Noyaux de parcours linéaire (recherche, égalité, test de tri, rang dans un bloc) : une version scalaire et
+ * des versions SSE2 / AVX2 / AVX-512 qui comparent 8 ou 16 entiers par itération.
+ * La version utilisée est choisie une seule fois au chargement du programme d'après CPUID.
+ * Chaque version passe la fin du tableau à la précédente. Les versions AVX2 appellent _mm256_zeroupper
+ * avant de passer la main aux versions SSE2, codées sans VEX : sinon chaque instruction SSE paie la
+ * transition entre les états AVX et SSE.
+ * Définir ARRAY_NO_SIMD à la compilation pour n'utiliser que la version scalaire.
+ */
+#if !defined(ARRAY_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ARRAY_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * count_less compte les valeurs plus petites que value parmi les n premières d'un bloc de
+ * ARRAY_BLOCK_SIZE entiers (n < ARRAY_BLOCK_SIZE). Les versions vectorielles lisent tout le bloc
+ * sans branchement et masquent les cases au delà de n, le bloc entier doit donc être lisible.
+ */
+#define ARRAY_BLOCK_SIZE 32
+
+struct array_kernels {
+  size_t (*search)(const int *data, size_t n, int value);
+  bool (*equals)(const int *lhs, const int *rhs, size_t n);
+  bool (*is_sorted)(const int *data, size_t n);
+  size_t (*count_less)(const int *data, size_t n, int value);
+};
+
+static size_t array_search_scalar(const int *data, size_t n, int value) {
+  for(size_t i = 0; i < n; ++i){
+    if(data[i] == value){
+      return i;
+    }
+  }
+  return n;
+}
+
+static bool array_equals_scalar(const int *lhs, const int *rhs, size_t n) {
+  for(size_t i = 0; i < n; ++i){
+    if(lhs[i] != rhs[i]){
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool array_is_sorted_scalar(const int *data, size_t n) {
+  for(size_t i = 1; i < n; ++i){
+    if(data[i-1] >= data[i]){
+      return false;
+    }
+  }
+  return true;
+}
+
+static size_t array_count_less_scalar(const int *data, size_t n, int value) {
+  size_t count = 0;
+  for(size_t i = 0; i < n; ++i){
+    count += (data[i] < value);
+  }
+  return count;
+}
+
+#ifdef ARRAY_SIMD_X86
+
+__attribute__((target("sse2")))
+static size_t array_search_sse2(const int *data, size_t n, int value) {
+  const __m128i key = _mm_set1_epi32(value);
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8){
+    __m128i lo = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(data + i)), key);
+    __m128i hi = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(data + i + 4)), key);
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(lo)) | (_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4);
+    if(mask != 0){
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + array_search_scalar(data + i, n - i, value);
+}
+
+__attribute__((target("sse2")))
+static bool array_equals_sse2(const int *lhs, const int *rhs, size_t n) {
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8){
+    __m128i lo = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(lhs + i)), _mm_loadu_si128((const __m128i *)(rhs + i)));
+    __m128i hi = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(lhs + i + 4)), _mm_loadu_si128((const __m128i *)(rhs + i + 4)));
+    if(_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(lo, hi))) != 0xF){
+      return false;
+    }
+  }
+  return array_equals_scalar(lhs + i, rhs + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static bool array_is_sorted_sse2(const int *data, size_t n) {
+  size_t i = 1;           //on compare data[i..i+8) à data[i-1..i+7)
+  for(; i + 8 <= n; i += 8){
+    __m128i lo = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(data + i)), _mm_loadu_si128((const __m128i *)(data + i - 1)));
+    __m128i hi = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(data + i + 4)), _mm_loadu_si128((const __m128i *)(data + i + 3)));
+    if(_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(lo, hi))) != 0xF){
+      return false;
+    }
+  }
+  return (n == 0) || array_is_sorted_scalar(data + i - 1, n - i + 1);
+}
+
+__attribute__((target("sse2")))
+static size_t array_count_less_sse2(const int *data, size_t n, int value) {
+  const __m128i key = _mm_set1_epi32(value);
+  uint32_t mask = 0;
+  for(size_t i = 0; i < ARRAY_BLOCK_SIZE; i += 4){
+    __m128i less = _mm_cmpgt_epi32(key, _mm_loadu_si128((const __m128i *)(data + i)));
+    mask |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(less)) << i;
+  }
+  return __builtin_popcount(mask & (((uint32_t)1 << n) - 1));
+}
+
+__attribute__((target("avx2")))
+static size_t array_search_avx2(const int *data, size_t n, int value) {
+  const __m256i key = _mm256_set1_epi32(value);
+  size_t i = 0;
+  for(; i + 16 <= n; i += 16){
+    __m256i lo = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(data + i)), key);
+    __m256i hi = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(data + i + 8)), key);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(lo)) | (_mm256_movemask_ps(_mm256_castsi256_ps(hi)) << 8);
+    if(mask != 0){
+      return i + __builtin_ctz(mask);
+    }
+  }
+  _mm256_zeroupper();
+  return i + array_search_sse2(data + i, n - i, value);
+}
+
+__attribute__((target("avx2")))
+static bool array_equals_avx2(const int *lhs, const int *rhs, size_t n) {
+  size_t i = 0;
+  for(; i + 16 <= n; i += 16){
+    __m256i lo = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(lhs + i)), _mm256_loadu_si256((const __m256i *)(rhs + i)));
+    __m256i hi = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(lhs + i + 8)), _mm256_loadu_si256((const __m256i *)(rhs + i + 8)));
+    if(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(lo, hi))) != 0xFF){
+      return false;
+    }
+  }
+  _mm256_zeroupper();
+  return array_equals_sse2(lhs + i, rhs + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static bool array_is_sorted_avx2(const int *data, size_t n) {
+  size_t i = 1;
+  for(; i + 16 <= n; i += 16){
+    __m256i lo = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)(data + i)), _mm256_loadu_si256((const __m256i *)(data + i - 1)));
+    __m256i hi = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)(data + i + 8)), _mm256_loadu_si256((const __m256i *)(data + i + 7)));
+    if(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(lo, hi))) != 0xFF){
+      return false;
+    }
+  }
+  _mm256_zeroupper();
+  return (n == 0) || array_is_sorted_sse2(data + i - 1, n - i + 1);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t array_count_less_avx2(const int *data, size_t n, int value) {
+  const __m256i key = _mm256_set1_epi32(value);
+  uint32_t mask = 0;
+  for(size_t i = 0; i < ARRAY_BLOCK_SIZE; i += 8){
+    __m256i less = _mm256_cmpgt_epi32(key, _mm256_loadu_si256((const __m256i *)(data + i)));
+    mask |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(less)) << i;
+  }
+  return __builtin_popcount(mask & (((uint32_t)1 << n) - 1));
+}
+
+__attribute__((target("avx512f")))
+static size_t array_search_avx512(const int *data, size_t n, int value) {
+  const __m512i key = _mm512_set1_epi32(value);
+  size_t i = 0;
+  for(; i + 16 <= n; i += 16){
+    __mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void *)(data + i)), key);
+    if(mask != 0){
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + array_search_avx2(data + i, n - i, value);
+}
+
+__attribute__((target("avx512f")))
+static bool array_equals_avx512(const int *lhs, const int *rhs, size_t n) {
+  size_t i = 0;
+  for(; i + 16 <= n; i += 16){
+    if(_mm512_cmpneq_epi32_mask(_mm512_loadu_si512((const void *)(lhs + i)), _mm512_loadu_si512((const void *)(rhs + i))) != 0){
+      return false;
+    }
+  }
+  return array_equals_avx2(lhs + i, rhs + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static bool array_is_sorted_avx512(const int *data, size_t n) {
+  size_t i = 1;
+  for(; i + 16 <= n; i += 16){
+    if(_mm512_cmpgt_epi32_mask(_mm512_loadu_si512((const void *)(data + i)), _mm512_loadu_si512((const void *)(data + i - 1))) != 0xFFFF){
+      return false;
+    }
+  }
+  return (n == 0) || array_is_sorted_avx2(data + i - 1, n - i + 1);
+}
+
+__attribute__((target("avx512f,popcnt")))
+static size_t array_count_less_avx512(const int *data, size_t n, int value) {
+  const __m512i key = _mm512_set1_epi32(value);
+  uint32_t lo = _mm512_cmplt_epi32_mask(_mm512_loadu_si512((const void *)data), key);
+  uint32_t hi = _mm512_cmplt_epi32_mask(_mm512_loadu_si512((const void *)(data + 16)), key);
+  return __builtin_popcount((lo | (hi << 16)) & (((uint32_t)1 << n) - 1));
+}
+
+#endif // ARRAY_SIMD_X86
+
+static struct array_kernels array_simd = {
+  array_search_scalar,
+  array_equals_scalar,
+  array_is_sorted_scalar,
+  array_count_less_scalar,
+};
+
+#ifdef ARRAY_SIMD_X86
+__attribute__((constructor))
+static void array_simd_init(void) {
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512f")){
+    array_simd.search = array_search_avx512;
+    array_simd.equals = array_equals_avx512;
+    array_simd.is_sorted = array_is_sorted_avx512;
+    array_simd.count_less = array_count_less_avx512;
+  }else if(__builtin_cpu_supports("avx2")){
+    array_simd.search = array_search_avx2;
+    array_simd.equals = array_equals_avx2;
+    array_simd.is_sorted = array_is_sorted_avx2;
+    array_simd.count_less = array_count_less_avx2;
+  }else if(__builtin_cpu_supports("sse2")){
+    array_simd.search = array_search_sse2;
+    array_simd.equals = array_equals_sse2;
+    array_simd.is_sorted = array_is_sorted_sse2;
+    array_simd.count_less = array_count_less_sse2;
+  }
+}
+#endif
+
+/*
+ * Politique de croissance et de réduction de la capacité du tableau :
+ * la capacité est multipliée par ARRAY_GROWTH_NUMERATOR / ARRAY_GROWTH_DENOMINATOR
+ * quand le tableau est plein, et divisée par deux quand le tableau n'est plus
+ * rempli qu'au 1 / ARRAY_SHRINK_THRESHOLD (hystérésis pour éviter les réallocations
+ * en boucle autour d'une même taille). Les valeurs peuvent être changées à la compilation.
+ */
+#ifndef ARRAY_GROWTH_NUMERATOR
+#define ARRAY_GROWTH_NUMERATOR 2
+#endif
+
+#ifndef ARRAY_GROWTH_DENOMINATOR
+#define ARRAY_GROWTH_DENOMINATOR 1
+#endif
+
+#ifndef ARRAY_SHRINK_THRESHOLD
+#define ARRAY_SHRINK_THRESHOLD 4
+#endif
+
+#ifndef ARRAY_MIN_CAPACITY
+#define ARRAY_MIN_CAPACITY 16
+#endif
+
+static void array_set_capacity(struct array *self, size_t capacity) {
+  if(capacity == 0){            //on garde toujours au moins une case allouée comme array_create
+    capacity = 1;
+  }
+  int *data = (capacity <= SIZE_MAX / sizeof(int)) ? realloc(self->data, capacity * sizeof(int)) : NULL;
+  if(data == NULL){
+    if(capacity < self->capacity){    //une réduction qui échoue n'est pas grave, on garde l'ancien tableau
+      return;
+    }
+    fprintf(stderr, "array: cannot allocate %zu elements\n", capacity); //les appelants écriraient hors du tableau
+    abort();
+  }
+  self->data = data;
+  self->capacity = capacity;
+}
+
+static void array_grow(struct array *self, size_t needed) {
+  if(needed <= self->capacity){
+    return;
+  }
+  size_t capacity = self->capacity * ARRAY_GROWTH_NUMERATOR / ARRAY_GROWTH_DENOMINATOR;
+  if(capacity <= self->capacity){ //le facteur doit toujours faire avancer la capacité
+    capacity = self->capacity + 1;
+  }
+  if(capacity < needed){
+    capacity = needed;
+  }
+  array_set_capacity(self, capacity);
+}
+
+static void array_shrink(struct array *self) {
+  if((self->capacity > ARRAY_MIN_CAPACITY)&&(self->size <= self->capacity / ARRAY_SHRINK_THRESHOLD)){
+    size_t capacity = self->capacity / 2;
+    if(capacity < ARRAY_MIN_CAPACITY){
+      capacity = ARRAY_MIN_CAPACITY;
+    }
+    array_set_capacity(self, capacity);
+  }
+}
 
 void array_create(struct array *self) {
   assert(self != NULL);
@@ -17,10 +341,10 @@ void array_create(struct array *self) {
 void array_create_from(struct array *self, const int *other, size_t size) {
   assert(self != NULL);
   self->size = size;
-  self->data = calloc(self->size, sizeof(int));
-  self->capacity = self->size;
-  for(size_t i = 0; i < size; ++i){ //on insère les éléments de other dans self->data
-    self->data[i] = other[i];
+  self->capacity = (size == 0) ? 1 : size;
+  self->data = malloc(self->capacity * sizeof(int));
+  if(size > 0){ //on copie les éléments de other dans self->data
+    memcpy(self->data, other, size * sizeof(int));
   }
 }
 
@@ -28,6 +352,8 @@ void array_destroy(struct array *self) {
   assert(self != NULL);
   free(self->data);
   self->data = NULL;
+  self->size = 0;
+  self->capacity = 0;
 }
 
 bool array_empty(const struct array *self) {
@@ -48,108 +374,48 @@ bool array_equals(const struct array *self, const int *content, size_t size) {
   if(array_size(self) != size){ //si les 2 tableaux ne sont pas de même taille renvoie faux
     return false;
   }
-  for(size_t i = 0; i < size; ++i){ //sinon on parcours les indices des 2 tableaux pour regarder leurs éléments
-    if(content[i] != self->data[i]){
-      return false;
-    }
+  return array_simd.equals(self->data, content, size); //sinon on compare les éléments par blocs
+}
+
+void array_reserve(struct array *self, size_t capacity) {
+  assert(self != NULL);
+  if(capacity > self->capacity){ //on alloue exactement la capacité demandée, sans appliquer le facteur de croissance
+    array_set_capacity(self, capacity);
   }
-  return true;
 }
 
+void array_shrink_to_fit(struct array *self) {
+  assert(self != NULL);
+  if(self->capacity > self->size){
+    array_set_capacity(self, self->size);
+  }
+}
 
 void array_push_back(struct array *self, int value) {
-  if(self->size == self->capacity){ //si la capacité du tableau est égale à sa taille alors on va allouer un tableau d'une capacité 2 fois plus grande que l'ancienne
-    self->capacity *= 2;
-    int *data_temp = calloc(self->capacity, sizeof(int));
-    for(size_t i = 0; i < array_size(self); ++i){
-      data_temp[i] = self->data[i];
-    }
-    free(self->data);
-    self->data = data_temp; 
-  }
-  self->data[self->size] = value; //on ajoute la valeur à l'indice de la taille du tableau
+  array_grow(self, self->size + 1); //on agrandit le tableau seulement s'il est plein
+  self->data[self->size] = value;   //on ajoute la valeur à l'indice de la taille du tableau
   self->size += 1;
 }
 
 void array_pop_back(struct array *self) {
-  int *data_temp = calloc(self->capacity, sizeof(int));
-  for(size_t i = 0; i < array_size(self)-1; ++i){
-    data_temp[i] = self->data[i];
-  }
-  free(self->data);
-  self->data = data_temp;
+  assert(!array_empty(self));
   self->size -= 1;
+  array_shrink(self);
 }
 
 void array_insert(struct array *self, int value, size_t index) {
-  if(index == array_size(self)){ //si on veut insérer à la fin alors on utilise la fonction array_push_back
-    array_push_back(self, value);
-  }else{
-    if(self->size == self->capacity){ //sinon si la taille est égale à la capacité on va allouer un tableau d'une capacité 2 fois plus grande que l'ancienne 
-      self->capacity *= 2;
-      int *data_temp = calloc(self->capacity + 1, sizeof(int));
-      if(index == 0){               //si l'index est égale à 0 alors on initalise l'indice 0 du nouveau tableau à la valeur est on y insère tous les autres éléments de self
-        data_temp[0] = value;
-        for(size_t i = 0; i < array_size(self); ++i){
-          data_temp[i+1] = self->data[i];
-        }
-      }else{                        //sinon on insère tous les éléments de self dans le nouveau tableau jusqu'à l'index puis ensuite on insère la valeur et enfin on insère le reste des éléments de self
-        for(size_t i = 0; i < index; ++i){
-          data_temp[i] = self->data[i];
-        }
-        data_temp[index] = value;
-        for(size_t i = index; i < array_size(self); ++i){
-          data_temp[i+1] = self->data[i];
-        }
-      }
-      free(self->data);
-      self->data = data_temp;
-    }else{
-      int *data_temp = calloc(self->capacity, sizeof(int)); //sinon on va allouer un nouveau tableau de la même taille pour insérer les éléments de self->data avec l'index en moins
-      if(index == 0){               //si l'index est égale à 0 alors on initalise l'indice 0 du nouveau tableau à la valeur est on y insère tous les autres éléments de self
-        data_temp[0] = value;
-        for(size_t i = 0; i < array_size(self); ++i){
-          data_temp[i+1] = self->data[i];
-        }
-      }else{                        //sinon on insère tous les éléments de self dans le nouveau tableau jusqu'à l'index puis ensuite on insère la valeur et enfin on insère le reste des éléments de self
-        for(size_t i = 0; i < index; ++i){
-          data_temp[i] = self->data[i];
-        }
-        data_temp[index] = value;
-        for(size_t i = index; i < array_size(self); ++i){
-          data_temp[i+1] = self->data[i];
-        }
-      }
-      free(self->data);
-      self->data = data_temp;
-    }
-    ++self->size;
-  }
+  assert(index <= self->size);
+  array_grow(self, self->size + 1);
+  memmove(self->data + index + 1, self->data + index, (self->size - index) * sizeof(int)); //on décale d'une case vers la droite les éléments après l'index
+  self->data[index] = value;
+  ++self->size;
 }
 
 void array_remove(struct array *self, size_t index) {
-  if(index == array_size(self)-1){                        //si on supprime à la fin alors on utilise la fonction array_pop_back
-    array_pop_back(self);
-  }else{
-    int *data_temp = calloc(self->capacity, sizeof(int)); //sinon on alloue un nouveau tableau iù on va insérer tous les éléments de self->data sauf celui situé à l'index
-    if(index == 0){
-      for(size_t i = 0; i < array_size(self)-1; ++i){
-        data_temp[i] = self->data[i+1];
-      }
-      free(self->data);
-      self->data = data_temp;
-    }else{
-      for(size_t i = 0; i < index; ++i){
-        data_temp[i] = self->data[i];
-      }
-      for(size_t i = index; i < array_size(self)-1; ++i){
-        data_temp[i] = self->data[i+1];
-      }
-      free(self->data);
-      self->data = data_temp;
-    }
-    --self->size;
-  }
+  assert(index < self->size);
+  memmove(self->data + index, self->data + index + 1, (self->size - index - 1) * sizeof(int)); //on décale d'une case vers la gauche les éléments après l'index
+  --self->size;
+  array_shrink(self);
 }
 
 int array_get(const struct array *self, size_t index) {
@@ -167,42 +433,172 @@ void array_set(struct array *self, size_t index, int value) {
 }
 
 size_t array_search(const struct array *self, int value) {
-  for(size_t i = 0; i < self->size; ++i){
-    if(self->data[i] == value){
-      return i;
-    }
+  return array_simd.search(self->data, self->size, value);
+}
+
+/*
+ * Recherches dans un tableau trié sans branchement : à chaque niveau la moitié
+ * est choisie par un déplacement conditionnel (cmov) au lieu d'un saut, et on
+ * précharge les deux milieux possibles du niveau suivant.
+ * Avec ARRAY_INTERPOLATION_MAX_PROBES sondes au plus, la recherche par
+ * interpolation ne dégénère pas sur des clés mal réparties.
+ */
+#ifndef ARRAY_INTERPOLATION_MAX_PROBES
+#define ARRAY_INTERPOLATION_MAX_PROBES 16
+#endif
+
+#ifndef ARRAY_INTERPOLATION_CUTOFF
+#define ARRAY_INTERPOLATION_CUTOFF 64
+#endif
+
+static size_t array_lower_bound_range(const int *data, size_t n, int value) {
+  if(n == 0){
+    return 0;
   }
-  return self->size;
+  const int *base = data;
+  while(n > 1){               //la réponse est toujours dans [base, base + n]
+    size_t half = n / 2;
+    PREFETCH(base + (n - half) / 2);
+    PREFETCH(base + half + (n - half) / 2);
+    base = (base[half] < value) ? base + half : base;
+    n -= half;
+  }
+  return (size_t)(base - data) + (*base < value);
 }
 
-size_t array_recherche_dichotomique(const struct array *self, size_t size, int value, size_t lo, size_t hi){
-  if(lo == hi){                                                                           //cas où le tableau est un seul élément
-    return size;
+static size_t array_upper_bound_range(const int *data, size_t n, int value) {
+  if(n == 0){
+    return 0;
   }
-  size_t moitie = (lo + hi) / 2;                                                          //on calcule l'indice de la moitie du tableau
-  if(value < self->data[moitie]){                                                         //si la valeur est plus petite que la veleur du milieu on effectue une recherche sur la premiere moitie du tablea
-    return array_recherche_dichotomique(self, size, value, lo, moitie);
+  const int *base = data;
+  while(n > 1){
+    size_t half = n / 2;
+    PREFETCH(base + (n - half) / 2);
+    PREFETCH(base + half + (n - half) / 2);
+    base = (base[half] <= value) ? base + half : base;
+    n -= half;
   }
-  if(value > self->data[moitie]){                                                         //sinon on effectue une recherche sur la deuxieme moitie du tableau
-    return array_recherche_dichotomique(self, size, value, moitie + 1, hi);
+  return (size_t)(base - data) + (*base <= value);
+}
+
+size_t array_lower_bound(const struct array *self, int value) {
+  assert(self != NULL);
+  return array_lower_bound_range(self->data, self->size, value);
+}
+
+size_t array_upper_bound(const struct array *self, int value) {
+  assert(self != NULL);
+  return array_upper_bound_range(self->data, self->size, value);
+}
+
+void array_equal_range(const struct array *self, int value, size_t *first, size_t *last) {
+  assert(self != NULL);
+  assert((first != NULL)&&(last != NULL));
+  *first = array_lower_bound_range(self->data, self->size, value);
+  *last = *first + array_upper_bound_range(self->data + *first, self->size - *first, value); //la fin ne peut pas être avant le début
+}
+
+size_t array_lower_bound_interpolation(const struct array *self, int value) {
+  assert(self != NULL);
+  const int *data = self->data;
+  size_t lo = 0;
+  size_t hi = self->size;     //la réponse est toujours dans [lo, hi]
+  for(int probe = 0; (probe < ARRAY_INTERPOLATION_MAX_PROBES)&&(hi - lo > ARRAY_INTERPOLATION_CUTOFF); ++probe){
+    int first = data[lo];
+    int last = data[hi - 1];
+    if(value <= first){
+      return lo;
+    }
+    if(value > last){
+      return hi;
+    }
+    //first < value <= last : on estime la position en supposant les clés uniformément réparties
+    double ratio = ((double)value - (double)first) / ((double)last - (double)first);
+    size_t pos = lo + (size_t)(ratio * (double)(hi - 1 - lo));
+    if(data[pos] < value){
+      lo = pos + 1;
+    }else{
+      hi = pos;
+    }
   }
-  return moitie;
+  return lo + array_lower_bound_range(data + lo, hi - lo, value);
 }
 
 size_t array_search_sorted(const struct array *self, int value) {
-  return array_recherche_dichotomique(self, array_size(self), value, 0, array_size(self));
+  size_t index = array_lower_bound(self, value); //on renvoie toujours la première occurrence de la valeur
+  if((index < self->size)&&(self->data[index] == value)){
+    return index;
+  }
+  return self->size;
 }
 
-bool array_is_sorted(const struct array *self) {
-  if(self->size == 0){
-    return true;
+/*
+ * Recherches groupées : ARRAY_BATCH_GROUP recherches dichotomiques avancent d'un niveau chacune à tour
+ * de rôle, et chacune précharge la case qu'elle lira au niveau suivant. Le temps d'accès à la mémoire
+ * d'une recherche est ainsi recouvert par le travail des autres.
+ */
+#ifndef ARRAY_BATCH_GROUP
+#define ARRAY_BATCH_GROUP 16
+#endif
+
+void array_search_sorted_batch(const struct array *self, const int *keys, size_t n, size_t *out) {
+  assert(self != NULL);
+  const int *data = self->data;
+  size_t size = self->size;
+  const int *base[ARRAY_BATCH_GROUP];
+  for(size_t first = 0; first < n; first += ARRAY_BATCH_GROUP){
+    size_t count = (n - first < ARRAY_BATCH_GROUP) ? n - first : ARRAY_BATCH_GROUP;
+    const int *group = keys + first;
+    if(size == 0){
+      for(size_t j = 0; j < count; ++j){
+        out[first + j] = 0;
+      }
+      continue;
+    }
+    for(size_t j = 0; j < count; ++j){
+      base[j] = data;
+    }
+    size_t len = size;                    //toutes les recherches ont la même longueur, elles avancent donc ensemble
+    while(len > 1){
+      size_t half = len / 2;
+      size_t next = (len - half) / 2;
+      for(size_t j = 0; j < count; ++j){
+        base[j] = (base[j][half] < group[j]) ? base[j] + half : base[j];
+        PREFETCH(base[j] + next);
+      }
+      len -= half;
+    }
+    for(size_t j = 0; j < count; ++j){
+      size_t index = (size_t)(base[j] - data) + (*base[j] < group[j]);
+      out[first + j] = ((index < size)&&(data[index] == group[j])) ? index : size;
+    }
   }
-  for(size_t i = 1; i < self->size; ++i){
-    if(self->data[i-1] >= self->data[i]){
-      return false;
+}
+
+void array_search_sorted_batch_ordered(const struct array *self, const int *keys, size_t n, size_t *out) {
+  assert(self != NULL);
+  const int *data = self->data;
+  size_t size = self->size;
+  size_t lo = 0;                          //les clés sont triées : la réponse ne peut pas être avant la précédente
+  for(size_t i = 0; i < n; ++i){
+    int key = keys[i];
+    size_t bound = lo;                    //recherche exponentielle à partir de la réponse précédente
+    size_t step = 1;
+    while((bound < size)&&(data[bound] < key)){
+      lo = bound + 1;
+      bound = lo + step;
+      step *= 2;
     }
+    if(bound > size){
+      bound = size;
+    }
+    lo += array_lower_bound_range(data + lo, bound - lo, key); //la réponse est dans [lo, bound]
+    out[i] = ((lo < size)&&(data[lo] == key)) ? lo : size;
   }
-  return true;
+}
+
+bool array_is_sorted(const struct array *self) {
+  return array_simd.is_sorted(self->data, self->size);
 }
 
 
@@ -226,597 +622,3779 @@ ptrdiff_t array_partition(struct array *self, ptrdiff_t i, ptrdiff_t j) {
   return l;
 }
 
-void array_quick_sort_recursive(struct array *self, ptrdiff_t i , ptrdiff_t j){
-  if(i < j){
-    ptrdiff_t indice_pivot = array_partition(self, i, j); //on recherche l'indice du pivot
-    array_quick_sort_recursive(self, i, indice_pivot);    //puis on va effectuer récursivement le tri rapide sur la partie gauche du tableau jusqu'au pivot
-    array_quick_sort_recursive(self, indice_pivot + 1, j); //puis sur la partie droite du tableau après le pivot
-  }
-}
+/*
+ * Tri introspectif : en dessous de ARRAY_INSERTION_SORT_THRESHOLD éléments on
+ * termine par un tri par insertion, et au delà de 2 * log2(n) niveaux de
+ * partitionnement on bascule sur le tri par tas pour garantir O(n log n).
+ */
+#ifndef ARRAY_INSERTION_SORT_THRESHOLD
+#define ARRAY_INSERTION_SORT_THRESHOLD 16
+#endif
 
-void array_quick_sort(struct array *self) {
-  array_quick_sort_recursive(self, 0, self->size - 1);
+#ifndef ARRAY_NINTHER_THRESHOLD
+#define ARRAY_NINTHER_THRESHOLD 128
+#endif
+
+static void array_swap(int *data, size_t i, size_t j) {
+  int temp = data[i];
+  data[i] = data[j];
+  data[j] = temp;
 }
 
-void array_heap_sort(struct array *self){
-  if(array_is_sorted(self)){
-    return;
+static size_t array_log2(size_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+  return (n > 1) ? (size_t)(8 * sizeof(unsigned long long) - 1 - __builtin_clzll(n)) : 0;
+#else
+  size_t res = 0;
+  while(n > 1){
+    n /= 2;
+    ++res;
   }
-  int i;
-  int hi = 0;
-  while(hi < (int)(self->size - 1)){                  //on effectue une boucle tant que le hi est plus petit que la taille du tableau
-    i = 0;
-    while(i < (int)(self->size - hi)){                //on effectue une boucle tant que i est plus petit que la taille du tableau moins hi
-      if(self->data[i] > self->data[(i - 1) / 2]){    //si la valeur à l'indice i est plus grande que son parent alors on va effectuer un echange entre le fils et le pere
-        int tmp = self->data[i];
-        self->data[i] = self->data[(i - 1) / 2];
-        self->data[(i - 1) / 2] = tmp;
-        i = 0;
-      }
-      ++i;
+  return res;
+#endif
+}
+
+static void array_insertion_sort_range(int *data, size_t lo, size_t hi) {
+  for(size_t i = lo + 1; i < hi; ++i){ //on insère data[i] dans la partie déjà triée [lo, i) en décalant les plus grands vers la droite
+    int value = data[i];
+    size_t j = i;
+    while((j > lo)&&(data[j - 1] > value)){
+      data[j] = data[j - 1];
+      --j;
     }
-    int tmp = self->data[self->size - hi - 1];        //on va effectuer un echange final entre la derniere valeur et la premiere
-    self->data[self->size - hi - 1] = self->data[0];
-    self->data[0] = tmp;
-    ++hi;
+    data[j] = value;
   }
 }
 
-bool array_is_heap(const struct array *self) {
-  if(array_empty(self)){                        //on teste le cas où self est un tableau vide
-    return true;
-  }
-  int i = self->size - 1;
-  while(i > 0){                       //on parcours le tableau depuis la fin jusqu'à la moitié
-    if(self->data[i] > self->data[(i - 1) / 2]){   //si le parent est inférieur au fils alors on retourne false
-      return false;
+/*
+ * Tas max stocké dans data[0..n) : on fait descendre data[i] tant qu'il est plus petit qu'un de ses fils
+ */
+static void array_sift_down(int *data, size_t i, size_t n) {
+  int value = data[i];
+  size_t child = 2 * i + 1;
+  while(child < n){
+    if((child + 1 < n)&&(data[child + 1] > data[child])){ //on choisit le plus grand des 2 fils
+      ++child;
     }
-    --i;
+    if(data[child] <= value){
+      break;
+    }
+    data[i] = data[child]; //on remonte le fils à la place du père au lieu de faire un échange complet
+    i = child;
+    child = 2 * i + 1;
   }
-  return true;
+  data[i] = value;
 }
 
+/*
+ * Variante "bottom-up" (rebond) : on descend jusqu'à une feuille en suivant le plus grand fils
+ * (une seule comparaison par niveau), puis on remonte jusqu'à la place de data[i]
+ */
+static void array_sift_down_bottom_up(int *data, size_t i, size_t n) {
+  int value = data[i];
+  size_t j = i;
+  while(2 * j + 2 < n){
+    j = (data[2 * j + 2] > data[2 * j + 1]) ? 2 * j + 2 : 2 * j + 1;
+  }
+  if(2 * j + 1 < n){
+    j = 2 * j + 1;
+  }
+  while(data[j] < value){ //s'arrête au plus tard en i puisque data[i] == value
+    j = (j - 1) / 2;
+  }
+  int temp = data[j];     //on décale d'un cran vers le haut le chemin entre i et j
+  data[j] = value;
+  while(j > i){
+    j = (j - 1) / 2;
+    int up = data[j];
+    data[j] = temp;
+    temp = up;
+  }
+}
 
+static void array_heap_build(int *data, size_t n, void (*sift_down)(int *, size_t, size_t)) {
+  for(size_t i = n / 2; i > 0; --i){ //construction du tas de bas en haut (Floyd) en O(n)
+    sift_down(data, i - 1, n);
+  }
+}
 
-void array_heap_add(struct array *self, int value) {
-  assert(array_is_heap(self));
-  size_t i = self->size;
-  array_push_back(self, value);                 //on va inserer la valeur à la fin du tableau
-  while(i > 0){                                 //on va effectuer un boucle pour remonter la valeur si elle est plus grande que son parent
-    size_t j = (i - 1) / 2;
-    if(self->data[i] < self->data[j]){
-      return;
-    }
-    int temp = self->data[i];
-    self->data[i] = self->data[j];
-    self->data[j]= temp;
-    i = j;
+static void array_heap_sort_with(int *data, size_t n, void (*sift_down)(int *, size_t, size_t)) {
+  if(n < 2){
+    return;
+  }
+  array_heap_build(data, n, sift_down);
+  for(size_t hi = n - 1; hi > 0; --hi){ //on place le maximum à la fin puis on répare le tas restant
+    array_swap(data, 0, hi);
+    sift_down(data, 0, hi);
   }
 }
 
-int array_heap_top(const struct array *self) {
-  return self->data[0];
+static void array_heap_sort_range(int *data, size_t n) {
+  array_heap_sort_with(data, n, array_sift_down);
 }
 
-void array_heap_remove_top(struct array *self) {
-  assert(array_is_heap(self));
-  self->data[0] = self->data[self->size - 1];                                     //on modifie la premiere valeur du tableau par la derniere
+static size_t array_median_of_three(const int *data, size_t a, size_t b, size_t c) {
+  if(data[a] < data[b]){
+    if(data[b] < data[c]){
+      return b;
+    }
+    return (data[a] < data[c]) ? c : a;
+  }
+  if(data[a] < data[c]){
+    return a;
+  }
+  return (data[b] < data[c]) ? c : b;
+}
+
+static int array_choose_pivot(const int *data, size_t lo, size_t hi) {
+  size_t n = hi - lo;
+  size_t mid = lo + n / 2;
+  if(n < ARRAY_NINTHER_THRESHOLD){ //médiane de 3 pour les petites parties
+    return data[array_median_of_three(data, lo, mid, hi - 1)];
+  }
+  size_t step = n / 8;              //sinon pseudo-médiane de 9 (ninther de Tukey)
+  size_t a = array_median_of_three(data, lo, lo + step, lo + 2 * step);
+  size_t b = array_median_of_three(data, mid - step, mid, mid + step);
+  size_t c = array_median_of_three(data, hi - 1 - 2 * step, hi - 1 - step, hi - 1);
+  return data[array_median_of_three(data, a, b, c)];
+}
+
+/*
+ * Partition en 3 (drapeau hollandais) : [lo, *lt) < pivot, [*lt, *gt) == pivot, [*gt, hi) > pivot
+ */
+static void array_partition_three_way(int *data, size_t lo, size_t hi, int pivot, size_t *lt, size_t *gt) {
+  size_t i = lo;
+  size_t j = lo;
+  size_t k = hi;
+  while(j < k){
+    if(data[j] < pivot){
+      array_swap(data, i, j);
+      ++i;
+      ++j;
+    }else if(data[j] > pivot){
+      --k;
+      array_swap(data, j, k);
+    }else{
+      ++j;
+    }
+  }
+  *lt = i;
+  *gt = k;
+}
+
+static void array_introsort(int *data, size_t lo, size_t hi, size_t depth) {
+  while(hi - lo > ARRAY_INSERTION_SORT_THRESHOLD){
+    if(depth == 0){                 //trop de partitionnements déséquilibrés : on finit avec le tri par tas
+      array_heap_sort_range(data + lo, hi - lo);
+      return;
+    }
+    --depth;
+    size_t lt;
+    size_t gt;
+    array_partition_three_way(data, lo, hi, array_choose_pivot(data, lo, hi), &lt, &gt);
+    if(lt - lo < hi - gt){          //on appelle récursivement sur la plus petite partie et on boucle sur la plus grande, la pile reste en O(log n)
+      array_introsort(data, lo, lt, depth);
+      lo = gt;
+    }else{
+      array_introsort(data, gt, hi, depth);
+      hi = lt;
+    }
+  }
+  array_insertion_sort_range(data, lo, hi);
+}
+
+void array_quick_sort(struct array *self) {
+  if(self->size < 2){
+    return;
+  }
+  array_introsort(self->data, 0, self->size, 2 * array_log2(self->size));
+}
+
+/*
+ * Tri par base (LSD) sur les clés 32 bits dont on inverse le bit de signe pour que l'ordre des entiers
+ * non signés soit celui des entiers signés. Les chiffres font ARRAY_RADIX_BITS bits (8 ou 11).
+ */
+#ifndef ARRAY_RADIX_BITS
+#define ARRAY_RADIX_BITS 11
+#endif
+
+#ifndef ARRAY_RADIX_THRESHOLD
+#define ARRAY_RADIX_THRESHOLD 256
+#endif
+
+#define ARRAY_RADIX_BUCKETS ((size_t)1 << ARRAY_RADIX_BITS)
+#define ARRAY_RADIX_PASSES ((32 + ARRAY_RADIX_BITS - 1) / ARRAY_RADIX_BITS)
+
+static inline uint32_t array_radix_key(int value) {
+  return (uint32_t)value ^ UINT32_C(0x80000000);
+}
+
+static inline size_t array_radix_digit(uint32_t key, size_t pass) {
+  return (key >> (pass * ARRAY_RADIX_BITS)) & (ARRAY_RADIX_BUCKETS - 1);
+}
+
+void array_radix_sort(struct array *self) {
+  size_t n = self->size;
+  if(n < ARRAY_RADIX_THRESHOLD){          //pour les petits tableaux le coût des histogrammes n'est pas rentabilisé
+    array_quick_sort(self);
+    return;
+  }
+  size_t *count = calloc(ARRAY_RADIX_PASSES * ARRAY_RADIX_BUCKETS, sizeof(size_t));
+  int *dst = malloc(self->capacity * sizeof(int)); //un seul tampon, de la capacité du tableau puisqu'il peut le remplacer
+  if((count == NULL)||(dst == NULL)){
+    fprintf(stderr, "array: cannot allocate %zu elements\n", self->capacity);
+    abort();
+  }
+  for(size_t i = 0; i < n; ++i){          //on calcule les histogrammes de toutes les passes en une seule lecture
+    uint32_t key = array_radix_key(self->data[i]);
+    for(size_t pass = 0; pass < ARRAY_RADIX_PASSES; ++pass){
+      ++count[pass * ARRAY_RADIX_BUCKETS + array_radix_digit(key, pass)];
+    }
+  }
+  int *src = self->data;                  //on alterne entre le tableau et le tampon à chaque passe
+  int *scratch = dst;
+  for(size_t pass = 0; pass < ARRAY_RADIX_PASSES; ++pass){
+    size_t *bucket = count + pass * ARRAY_RADIX_BUCKETS;
+    if(bucket[array_radix_digit(array_radix_key(src[0]), pass)] == n){ //toutes les clés ont le même chiffre : la passe ne changerait rien
+      continue;
+    }
+    size_t offset = 0;                    //les compteurs deviennent les positions de début de chaque paquet
+    for(size_t b = 0; b < ARRAY_RADIX_BUCKETS; ++b){
+      size_t c = bucket[b];
+      bucket[b] = offset;
+      offset += c;
+    }
+    for(size_t i = 0; i < n; ++i){
+      int value = src[i];
+      dst[bucket[array_radix_digit(array_radix_key(value), pass)]++] = value;
+    }
+    int *temp = src;
+    src = dst;
+    dst = temp;
+  }
+  if(src != self->data){                  //le résultat est dans le tampon : on le garde à la place de l'ancien tableau
+    free(self->data);
+    self->data = src;
+  }else{
+    free(scratch);
+  }
+  free(count);
+}
+
+/*
+ * Pool de threads à vol de travail (fork / join)
+ *
+ * Chaque thread possède une file de tâches : il ajoute et reprend ses propres tâches par le bas
+ * (les plus récentes, encore chaudes dans le cache) et vole les tâches des autres par le haut
+ * (les plus anciennes, donc les plus grosses en diviser pour régner). Le thread appelant est le
+ * travailleur 0. Attendre une tâche (task_pool_join) exécute d'autres tâches en attendant, et
+ * s'il n'y a rien à prendre, dort jusqu'à la fin de la tâche ou l'arrivée d'une nouvelle.
+ */
+enum task_state {
+  TASK_PENDING,
+  TASK_WAITED,                              //quelqu'un dort dans task_pool_join en attendant la fin
+  TASK_DONE
+};
+
+struct task {
+  void (*func)(void *arg);
+  void *arg;
+  atomic_int state;
+};
+
+struct task_deque {
+  pthread_mutex_t lock;
+  struct task **tasks;
+  size_t top;
+  size_t bottom;
+  size_t capacity;
+};
+
+struct task_pool;
+
+struct task_worker {
+  struct task_pool *pool;
+  size_t index;
+};
+
+struct task_pool {
+  size_t size;
+  struct task_deque *deques;
+  struct task_worker *workers;
+  pthread_t *threads;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  atomic_size_t queued;
+  atomic_size_t sleeping;
+  atomic_bool stop;
+  struct task_worker previous;              //rôle du thread créateur avant ce pool, un pool peut être créé depuis une tâche
+};
+
+static _Thread_local struct task_worker task_worker_self;
+
+static void task_deque_push(struct task_deque *self, struct task *task) {
+  pthread_mutex_lock(&self->lock);
+  if(self->bottom == self->capacity){
+    if(self->top > 0){                      //on récupère la place libérée en haut par les vols
+      memmove(self->tasks, self->tasks + self->top, (self->bottom - self->top) * sizeof(struct task *));
+      self->bottom -= self->top;
+      self->top = 0;
+    }else{
+      self->capacity = (self->capacity == 0) ? 64 : 2 * self->capacity;
+      self->tasks = realloc(self->tasks, self->capacity * sizeof(struct task *));
+      if(self->tasks == NULL){
+        fprintf(stderr, "task_pool: cannot allocate %zu tasks\n", self->capacity);
+        abort();
+      }
+    }
+  }
+  self->tasks[self->bottom++] = task;
+  pthread_mutex_unlock(&self->lock);
+}
+
+static struct task *task_deque_pop(struct task_deque *self, bool steal) {
+  struct task *task = NULL;
+  pthread_mutex_lock(&self->lock);
+  if(self->bottom > self->top){
+    task = steal ? self->tasks[self->top++] : self->tasks[--self->bottom];
+    if(self->top == self->bottom){
+      self->top = 0;
+      self->bottom = 0;
+    }
+  }
+  pthread_mutex_unlock(&self->lock);
+  return task;
+}
+
+static struct task *task_pool_take(struct task_pool *self, size_t index) {
+  struct task *task = task_deque_pop(&self->deques[index], false);
+  for(size_t k = 1; (task == NULL)&&(k < self->size); ++k){ //sinon on essaie de voler les autres threads
+    task = task_deque_pop(&self->deques[(index + k) % self->size], true);
+  }
+  if(task != NULL){
+    atomic_fetch_sub(&self->queued, 1);
+  }
+  return task;
+}
+
+static void task_run(struct task_pool *self, struct task *task) {
+  task->func(task->arg);
+  int pending = TASK_PENDING;
+  if(!atomic_compare_exchange_strong_explicit(&task->state, &pending, TASK_DONE, memory_order_acq_rel, memory_order_acquire)){
+    pthread_mutex_lock(&self->lock);        //le thread qui attend dort : on le réveille sous le verrou
+    atomic_store_explicit(&task->state, TASK_DONE, memory_order_release); //dernier accès, la tâche peut vivre sur sa pile
+    pthread_cond_broadcast(&self->wake);
+    pthread_mutex_unlock(&self->lock);
+  }
+}
+
+static void *task_pool_worker(void *arg) {
+  struct task_worker *worker = arg;
+  struct task_pool *self = worker->pool;
+  task_worker_self = *worker;
+  pthread_mutex_lock(&self->lock);          //attend que task_pool_create ait fixé le nombre de threads
+  pthread_mutex_unlock(&self->lock);
+  while(!atomic_load(&self->stop)){
+    struct task *task = task_pool_take(self, worker->index);
+    if(task != NULL){
+      task_run(self, task);
+      continue;
+    }
+    pthread_mutex_lock(&self->lock);        //rien à faire : on dort jusqu'au prochain task_pool_spawn
+    atomic_fetch_add(&self->sleeping, 1);
+    while((atomic_load(&self->queued) == 0)&&(!atomic_load(&self->stop))){
+      pthread_cond_wait(&self->wake, &self->lock);
+    }
+    atomic_fetch_sub(&self->sleeping, 1);
+    pthread_mutex_unlock(&self->lock);
+  }
+  return NULL;
+}
+
+static size_t task_pool_default_size(void) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return (cpus > 0) ? (size_t)cpus : 1;
+}
+
+/*
+ * Crée un pool de size threads (0 pour le nombre de processeurs), le thread appelant compris.
+ * Si un thread ne peut pas être créé, le pool se contente de ceux qui ont démarré.
+ */
+static void task_pool_create(struct task_pool *self, size_t size) {
+  if(size == 0){
+    size = task_pool_default_size();
+  }
+  self->size = size;
+  self->deques = calloc(size, sizeof(struct task_deque));
+  self->workers = calloc(size, sizeof(struct task_worker));
+  self->threads = calloc(size, sizeof(pthread_t));
+  if((self->deques == NULL)||(self->workers == NULL)||(self->threads == NULL)){
+    fprintf(stderr, "task_pool: cannot allocate %zu workers\n", size);
+    abort();
+  }
+  pthread_mutex_init(&self->lock, NULL);
+  pthread_cond_init(&self->wake, NULL);
+  atomic_init(&self->queued, 0);
+  atomic_init(&self->sleeping, 0);
+  atomic_init(&self->stop, false);
+  for(size_t i = 0; i < size; ++i){
+    pthread_mutex_init(&self->deques[i].lock, NULL);
+    self->workers[i].pool = self;
+    self->workers[i].index = i;
+  }
+  self->previous = task_worker_self;
+  task_worker_self = self->workers[0];
+  pthread_mutex_lock(&self->lock);          //les threads démarrés attendent la taille définitive
+  size_t started = 1;
+  while((started < size)&&(pthread_create(&self->threads[started], NULL, task_pool_worker, &self->workers[started]) == 0)){
+    ++started;
+  }
+  for(size_t i = started; i < size; ++i){
+    pthread_mutex_destroy(&self->deques[i].lock);
+  }
+  self->size = started;
+  pthread_mutex_unlock(&self->lock);
+}
+
+static void task_pool_destroy(struct task_pool *self) {
+  assert(task_worker_self.pool == self);    //détruit par le thread qui l'a créé, après les pools créés ensuite
+  pthread_mutex_lock(&self->lock);
+  atomic_store(&self->stop, true);
+  pthread_cond_broadcast(&self->wake);
+  pthread_mutex_unlock(&self->lock);
+  for(size_t i = 1; i < self->size; ++i){
+    pthread_join(self->threads[i], NULL);
+  }
+  for(size_t i = 0; i < self->size; ++i){
+    pthread_mutex_destroy(&self->deques[i].lock);
+    free(self->deques[i].tasks);
+  }
+  pthread_cond_destroy(&self->wake);
+  pthread_mutex_destroy(&self->lock);
+  free(self->threads);
+  free(self->workers);
+  free(self->deques);
+  task_worker_self = self->previous;
+}
+
+/*
+ * Rend la tâche disponible pour les autres threads, elle doit être attendue avec task_pool_join
+ */
+static void task_pool_spawn(struct task_pool *self, struct task *task, void (*func)(void *), void *arg) {
+  assert(task_worker_self.pool == self);
+  task->func = func;
+  task->arg = arg;
+  atomic_init(&task->state, TASK_PENDING);
+  task_deque_push(&self->deques[task_worker_self.index], task);
+  atomic_fetch_add(&self->queued, 1);
+  if(atomic_load(&self->sleeping) > 0){
+    pthread_mutex_lock(&self->lock);
+    pthread_cond_signal(&self->wake);
+    pthread_mutex_unlock(&self->lock);
+  }
+}
+
+static void task_pool_join(struct task_pool *self, struct task *task) {
+  while(atomic_load_explicit(&task->state, memory_order_acquire) != TASK_DONE){
+    struct task *other = task_pool_take(self, task_worker_self.index); //le plus souvent c'est la tâche attendue elle-même
+    if(other != NULL){
+      task_run(self, other);
+      continue;
+    }
+    pthread_mutex_lock(&self->lock);        //elle est en cours ailleurs : on dort jusqu'à sa fin ou une nouvelle tâche
+    int pending = TASK_PENDING;
+    atomic_compare_exchange_strong_explicit(&task->state, &pending, TASK_WAITED, memory_order_acq_rel, memory_order_acquire);
+    atomic_fetch_add(&self->sleeping, 1);
+    while((atomic_load_explicit(&task->state, memory_order_acquire) != TASK_DONE)&&(atomic_load(&self->queued) == 0)){
+      pthread_cond_wait(&self->wake, &self->lock);
+    }
+    atomic_fetch_sub(&self->sleeping, 1);
+    pthread_mutex_unlock(&self->lock);
+  }
+}
+
+/*
+ * Tri fusion parallèle : les deux moitiés sont triées en parallèle puis fusionnées en parallèle
+ * (on coupe la plus grande moitié en son milieu et on cherche la position correspondante dans l'autre).
+ * Le résultat alterne entre le tableau et un tampon de même taille pour éviter les recopies.
+ */
+#ifndef ARRAY_PARALLEL_THRESHOLD
+#define ARRAY_PARALLEL_THRESHOLD 65536
+#endif
+
+#ifndef ARRAY_PARALLEL_MIN_GRAIN
+#define ARRAY_PARALLEL_MIN_GRAIN 8192
+#endif
+
+struct array_merge_job {
+  struct task_pool *pool;
+  const int *lhs;
+  size_t lhs_size;
+  const int *rhs;
+  size_t rhs_size;
+  int *out;
+  size_t grain;
+};
+
+static void array_merge_range(const int *lhs, size_t lhs_size, const int *rhs, size_t rhs_size, int *out) {
   size_t i = 0;
-  while(i < (self->size - 1) / 2){                                                //on va effectuer une boucle pour descendre la premiere valeur si elle est plus petite qu'une des 2 valeurs de ses fils
-    size_t left = 2 * i + 1;
-    size_t right = 2 * i + 2;
-    if((self->data[i] > self->data[left])&&(self->data[i] > self->data[right])){
+  size_t j = 0;
+  while((i < lhs_size)&&(j < rhs_size)){
+    *out++ = (rhs[j] < lhs[i]) ? rhs[j++] : lhs[i++];
+  }
+  memcpy(out, lhs + i, (lhs_size - i) * sizeof(int));
+  memcpy(out + lhs_size - i, rhs + j, (rhs_size - j) * sizeof(int));
+}
+
+static void array_parallel_merge(void *arg) {
+  struct array_merge_job *job = arg;
+  if(job->lhs_size < job->rhs_size){        //on coupe toujours la plus grande partie
+    const int *data = job->lhs;
+    size_t size = job->lhs_size;
+    job->lhs = job->rhs;
+    job->lhs_size = job->rhs_size;
+    job->rhs = data;
+    job->rhs_size = size;
+  }
+  if(job->lhs_size + job->rhs_size <= job->grain){
+    array_merge_range(job->lhs, job->lhs_size, job->rhs, job->rhs_size, job->out);
+    return;
+  }
+  size_t mid = job->lhs_size / 2;
+  size_t pos = array_lower_bound_range(job->rhs, job->rhs_size, job->lhs[mid]);
+  job->out[mid + pos] = job->lhs[mid];
+  struct array_merge_job left = { job->pool, job->lhs, mid, job->rhs, pos, job->out, job->grain };
+  struct array_merge_job right = { job->pool, job->lhs + mid + 1, job->lhs_size - mid - 1, job->rhs + pos, job->rhs_size - pos, job->out + mid + pos + 1, job->grain };
+  struct task task;
+  task_pool_spawn(job->pool, &task, array_parallel_merge, &left);
+  array_parallel_merge(&right);
+  task_pool_join(job->pool, &task);
+}
+
+struct array_sort_job {
+  struct task_pool *pool;
+  int *data;
+  int *buffer;
+  size_t size;
+  bool in_buffer;                         //le résultat trié doit se trouver dans buffer plutôt que dans data
+  size_t grain;
+};
+
+static void array_parallel_merge_sort(void *arg) {
+  struct array_sort_job *job = arg;
+  if(job->size <= job->grain){
+    array_introsort(job->data, 0, job->size, 2 * array_log2(job->size));
+    if(job->in_buffer){
+      memcpy(job->buffer, job->data, job->size * sizeof(int));
+    }
+    return;
+  }
+  size_t half = job->size / 2;
+  struct array_sort_job left = { job->pool, job->data, job->buffer, half, !job->in_buffer, job->grain };
+  struct array_sort_job right = { job->pool, job->data + half, job->buffer + half, job->size - half, !job->in_buffer, job->grain };
+  struct task task;
+  task_pool_spawn(job->pool, &task, array_parallel_merge_sort, &left);
+  array_parallel_merge_sort(&right);
+  task_pool_join(job->pool, &task);
+  const int *src = job->in_buffer ? job->data : job->buffer; //les deux moitiés sont triées dans l'autre tableau
+  int *dst = job->in_buffer ? job->buffer : job->data;
+  struct array_merge_job merge = { job->pool, src, half, src + half, job->size - half, dst, job->grain };
+  array_parallel_merge(&merge);
+}
+
+void array_parallel_sort(struct array *self, unsigned threads) {
+  if(threads == 0){
+    threads = (unsigned)task_pool_default_size();
+  }
+  if((threads < 2)||(self->size < ARRAY_PARALLEL_THRESHOLD)){ //pas assez de travail pour rentabiliser les threads
+    array_quick_sort(self);
+    return;
+  }
+  size_t grain = self->size / (8 * (size_t)threads); //environ 8 tâches par thread pour équilibrer la charge
+  if(grain < ARRAY_PARALLEL_MIN_GRAIN){
+    grain = ARRAY_PARALLEL_MIN_GRAIN;
+  }
+  struct task_pool pool;
+  task_pool_create(&pool, threads);
+  int *buffer = malloc(self->size * sizeof(int));
+  struct array_sort_job job = { &pool, self->data, buffer, self->size, false, grain };
+  array_parallel_merge_sort(&job);
+  task_pool_destroy(&pool);
+  free(buffer);
+}
+
+void array_heap_sort(struct array *self){
+  array_heap_sort_with(self->data, self->size, array_sift_down);
+}
+
+void array_heap_sort_bottom_up(struct array *self){
+  array_heap_sort_with(self->data, self->size, array_sift_down_bottom_up);
+}
+
+void array_heapify(struct array *self) {
+  array_heap_build(self->data, self->size, array_sift_down);
+}
+
+bool array_is_heap(const struct array *self) {
+  if(array_empty(self)){                        //on teste le cas où self est un tableau vide
+    return true;
+  }
+  int i = self->size - 1;
+  while(i > 0){                       //on parcours le tableau depuis la fin jusqu'à la moitié
+    if(self->data[i] > self->data[(i - 1) / 2]){   //si le parent est inférieur au fils alors on retourne false
+      return false;
+    }
+    --i;
+  }
+  return true;
+}
+
+
+
+void array_heap_add(struct array *self, int value) {
+  assert(array_is_heap(self));
+  size_t i = self->size;
+  array_push_back(self, value);                 //on va inserer la valeur à la fin du tableau
+  while(i > 0){                                 //on va effectuer un boucle pour remonter la valeur si elle est plus grande que son parent
+    size_t j = (i - 1) / 2;
+    if(self->data[i] < self->data[j]){
       return;
     }
-    size_t j = (self->data[left] > self->data[right]) ? left : right;
     int temp = self->data[i];
     self->data[i] = self->data[j];
     self->data[j]= temp;
     i = j;
   }
+}
+
+int array_heap_top(const struct array *self) {
+  return self->data[0];
+}
+
+void array_heap_remove_top(struct array *self) {
+  assert(array_is_heap(self));
+  assert(!array_empty(self));
   --self->size;
+  self->data[0] = self->data[self->size]; //on remplace la premiere valeur du tableau par la derniere puis on la fait descendre
+  array_sift_down(self->data, 0, self->size);
 }
 
 
 
 /*
- * list
+ * array_index
  */
 
+/*
+ * Le tableau trié est rangé dans l'ordre d'un parcours en largeur d'un arbre binaire de recherche
+ * complet (disposition d'Eytzinger) : le noeud k a pour fils 2k et 2k + 1, la case 0 n'est pas utilisée.
+ * Les 16 descendants de k à 4 niveaux en dessous (16k .. 16k + 15) tiennent dans une seule ligne de cache
+ * de 64 octets car le tableau est aligné sur 64 octets.
+ */
+#define ARRAY_INDEX_ALIGNMENT 64
 
+/*
+ * Position dans le tableau trié du noeud k : on calcule sa position dans l'arbre parfait de même hauteur
+ * puis on enlève les feuilles absentes du dernier niveau (qui est rempli par la gauche) situées avant lui
+ */
+static size_t array_index_rank(const struct array_index *self, size_t k) {
+  size_t depth = array_log2(k);
+  size_t pos = ((2 * (k - ((size_t)1 << depth)) + 1) << (self->height - 1 - depth)) - 1;
+  size_t leaves = self->size - (((size_t)1 << (self->height - 1)) - 1);
+  if(pos > 2 * leaves){
+    pos -= (pos - 2 * leaves + 1) / 2;
+  }
+  return pos;
+}
 
-void list_create(struct list *self) {
+void array_index_build(struct array_index *self, const struct array *sorted) {
   assert(self != NULL);
-  self->first = NULL;
-  self->last = NULL;
+  assert(sorted != NULL);
+  self->size = sorted->size;
+  self->height = (self->size == 0) ? 0 : array_log2(self->size) + 1;
+  size_t bytes = (self->size + 1) * sizeof(int);
+  bytes = (bytes + ARRAY_INDEX_ALIGNMENT - 1) / ARRAY_INDEX_ALIGNMENT * ARRAY_INDEX_ALIGNMENT; //aligned_alloc veut un multiple de l'alignement
+  self->data = aligned_alloc(ARRAY_INDEX_ALIGNMENT, bytes);
+  if(self->data == NULL){
+    fprintf(stderr, "array_index: cannot allocate %zu elements\n", self->size + 1);
+    abort();
+  }
+  self->data[0] = 0;
+  for(size_t k = 1; k <= self->size; ++k){ //écritures séquentielles, les lectures dans le tableau trié sont par pas réguliers
+    self->data[k] = sorted->data[array_index_rank(self, k)];
+  }
 }
 
-void list_create_from(struct list *self, const int *other, size_t size) {
+void array_index_destroy(struct array_index *self) {
   assert(self != NULL);
-  list_create(self);
-  for(size_t i = 0; i < size; ++i){
-    list_push_back(self, other[i]);
-  }
+  free(self->data);
+  self->data = NULL;
+  self->size = 0;
+  self->height = 0;
 }
 
-void list_destroy(struct list *self) {
+size_t array_index_search(const struct array_index *self, int value) {
   assert(self != NULL);
-  while(self->first != NULL){
-    list_pop_back(self);
+  const int *data = self->data;
+  size_t k = 1;
+  while(k <= self->size){
+    PREFETCH((const void *)((uintptr_t)data + 16 * k * sizeof(int))); //ligne de cache des arrière-arrière-petits-enfants
+    k = 2 * k + (data[k] < value);
+  }
+  //on remonte de toutes les descentes à droite faites depuis le dernier noeud >= value
+#if defined(__GNUC__) || defined(__clang__)
+  k >>= __builtin_ctzll(~(unsigned long long)k) + 1;
+#else
+  while(k & 1){
+    k >>= 1;
   }
+  k >>= 1;
+#endif
+  if((k == 0)||(data[k] != value)){
+    return self->size;
+  }
+  return array_index_rank(self, k);
 }
 
-bool list_empty(const struct list *self) {
-  assert(self != NULL);
-  return ((self->first == NULL)&&(self->last == NULL));
+
+
+/*
+ * pqueue
+ */
+
+/*
+ * Tas d-aire stocké dans un struct array : les fils du noeud i sont d * i + 1 .. d * i + d.
+ * Avec 4 fils le tas est deux fois moins haut et les fils d'un noeud tiennent dans 16 octets.
+ * En mode min on stocke ~value, qui inverse l'ordre des entiers sans débordement possible :
+ * le tas est donc toujours un tas max et les comparaisons n'ont pas à tester le mode.
+ */
+#ifndef PQUEUE_ARITY
+#define PQUEUE_ARITY 4
+#endif
+
+static inline int pqueue_key(const struct pqueue *self, int value) {
+  return self->min ? ~value : value;
 }
 
-int list_size_rec(const struct list_node *self){
-  if(self->next == NULL){
-    return 0;
+static void pqueue_sift_up(int *data, size_t i) {
+  int value = data[i];
+  while(i > 0){
+    size_t parent = (i - 1) / PQUEUE_ARITY;
+    if(data[parent] >= value){
+      break;
+    }
+    data[i] = data[parent];
+    i = parent;
   }
-  return 1 + list_size_rec(self->next);
+  data[i] = value;
 }
 
-size_t list_size(const struct list *self) {
-  assert(self != NULL);
-  if(list_empty(self)){
-    return 0;
+static void pqueue_sift_down(int *data, size_t i, size_t n) {
+  int value = data[i];
+  for(;;){
+    size_t first = PQUEUE_ARITY * i + 1;
+    if(first >= n){
+      break;
+    }
+    size_t last = (first + PQUEUE_ARITY < n) ? first + PQUEUE_ARITY : n;
+    size_t best = first;                  //on cherche le plus grand des fils
+    for(size_t child = first + 1; child < last; ++child){
+      if(data[child] > data[best]){
+        best = child;
+      }
+    }
+    if(data[best] <= value){
+      break;
+    }
+    data[i] = data[best];
+    i = best;
   }
-  return 1 + list_size_rec(self->first);
+  data[i] = value;
 }
 
-bool list_equals(const struct list *self, const int *data, size_t size) {
-  struct list_node *courant = self->first;
-  if((list_size(self) != size)||(courant->data != data[0])){ //on vérifie le cas où ils n'auraient pas la même taille ou les cas où leurs premiers éléments sont différents
-    return false;
+void pqueue_create(struct pqueue *self, bool min) {
+  assert(self != NULL);
+  array_create(&self->heap);
+  self->min = min;
+}
+
+void pqueue_create_from(struct pqueue *self, const int *other, size_t size, bool min) {
+  assert(self != NULL);
+  array_create_from(&self->heap, other, size);
+  self->min = min;
+  int *data = self->heap.data;
+  for(size_t i = 0; i < size; ++i){
+    data[i] = pqueue_key(self, data[i]);
   }
-  courant = courant->next;
-  for(size_t i = 1; i < size; ++i){   //ensuite on va effectuer un parcours où on va regarder chaque éléments un par un
-    if(data[i] != courant->data){
-      return false;
+  if(size > 1){
+    for(size_t i = (size - 2) / PQUEUE_ARITY + 1; i > 0; --i){ //construction de bas en haut en O(n)
+      pqueue_sift_down(data, i - 1, size);
     }
-    courant = courant->next;
   }
-  return true;
 }
 
-void list_push_front(struct list *self, int value) {
-  if(list_empty(self)){
-    self->first = malloc(sizeof(struct list_node)); //si la liste est vide on va initialisé self->first et self->last à la même valeur
-    self->first->data = value;
-    self->first->next = NULL;
-    self->first->prev = NULL;
-    self->last = self->first;
-  }else{  
-    struct list_node *push = malloc(sizeof(struct list_node));  //sinon le prev de self->first devient le nouveau noeud et le next du nouveau noeud  devient self->first
-    push->data = value;
-    self->first->prev = push;
-    push->next = self->first;
-    push->prev = NULL;
-    self->first = push;
-  }  
+void pqueue_destroy(struct pqueue *self) {
+  assert(self != NULL);
+  array_destroy(&self->heap);
 }
 
-void list_pop_front(struct list *self) {
-  assert(!list_empty(self));
-  if(list_size(self) == 1){             //si la liste à une taille de 1 on va supprimer juste self->first qui est aussi égal à self->last et mettre ses 2 à NULL
-    free(self->first);
-    self->first = NULL;
-    self->last = NULL;
-  }else{
+bool pqueue_empty(const struct pqueue *self) {
+  assert(self != NULL);
+  return array_empty(&self->heap);
+}
+
+size_t pqueue_size(const struct pqueue *self) {
+  assert(self != NULL);
+  return array_size(&self->heap);
+}
+
+int pqueue_top(const struct pqueue *self) {
+  assert(!pqueue_empty(self));
+  return pqueue_key(self, self->heap.data[0]);
+}
+
+void pqueue_push(struct pqueue *self, int value) {
+  assert(self != NULL);
+  array_push_back(&self->heap, pqueue_key(self, value));
+  pqueue_sift_up(self->heap.data, self->heap.size - 1);
+}
+
+void pqueue_pop(struct pqueue *self) {
+  assert(!pqueue_empty(self));
+  int last = self->heap.data[self->heap.size - 1];
+  array_pop_back(&self->heap);
+  if(!array_empty(&self->heap)){
+    self->heap.data[0] = last;
+    pqueue_sift_down(self->heap.data, 0, self->heap.size);
+  }
+}
+
+int pqueue_push_pop(struct pqueue *self, int value) {
+  assert(self != NULL);
+  int key = pqueue_key(self, value);
+  if((pqueue_empty(self))||(key >= self->heap.data[0])){ //la valeur ajoutée serait tout de suite retirée
+    return value;
+  }
+  int top = self->heap.data[0];
+  self->heap.data[0] = key;
+  pqueue_sift_down(self->heap.data, 0, self->heap.size);
+  return pqueue_key(self, top);
+}
+
+int pqueue_replace_top(struct pqueue *self, int value) {
+  assert(!pqueue_empty(self));
+  int top = self->heap.data[0];
+  self->heap.data[0] = pqueue_key(self, value);
+  pqueue_sift_down(self->heap.data, 0, self->heap.size);
+  return pqueue_key(self, top);
+}
+
+
+
+/*
+ * node_pool
+ */
+
+
+
+/*
+ * Taille d'une plaque : une seule allocation découpée en noeuds. L'en-tête de la plaque (le chaînage
+ * des plaques) est aligné comme max_align_t pour que les noeuds le soient aussi.
+ */
+#define NODE_POOL_SLAB_SIZE 16384
+
+/*
+ * Cache de noeuds libres par thread pour les pools partagés : on le remplit ou le vide par lots
+ * de NODE_POOL_CACHE_BATCH noeuds pour ne prendre le verrou qu'une fois par lot
+ */
+#define NODE_POOL_CACHE_SIZE 64
+#define NODE_POOL_CACHE_BATCH (NODE_POOL_CACHE_SIZE / 2)
+
+/*
+ * Nombre de pools partagés dont un thread garde un cache en même temps
+ */
+#define NODE_POOL_CACHES 4
+
+struct node_pool_slab {
+  struct node_pool_slab *next;
+  _Alignas(max_align_t) char nodes[];
+};
+
+/*
+ * Un cache appartient à un pool, identifié par sa génération. Chaque création ou libération de pool
+ * prend une nouvelle génération. Quand un thread réutilise un cache pour un autre pool, les noeuds
+ * du cache sont rendus à leur pool, retrouvé par sa génération parmi les pools partagés existants :
+ * s'il n'y est plus, ses plaques ont été libérées et les noeuds sont simplement oubliés.
+ */
+struct node_pool_cache {
+  size_t generation;
+  size_t count;
+  void *nodes[NODE_POOL_CACHE_SIZE];
+};
+
+static atomic_size_t node_pool_generations = 1;
+static _Thread_local struct node_pool_cache node_pool_caches[NODE_POOL_CACHES];
+static _Thread_local size_t node_pool_cache_victim;
+
+static pthread_mutex_t node_pool_registry_lock = PTHREAD_MUTEX_INITIALIZER; //pris avant le verrou d'un pool
+static struct node_pool *node_pool_registry;                                 //les pools partagés existants
+
+void node_pool_create(struct node_pool *self, size_t node_size, bool shared) {
+  assert(self != NULL);
+  assert(node_size > 0);
+  node_size = (node_size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *); //un noeud libre stocke le suivant de la liste libre
+  self->node_size = node_size;
+  self->slab_nodes = (NODE_POOL_SLAB_SIZE - sizeof(struct node_pool_slab)) / node_size;
+  if(self->slab_nodes == 0){
+    self->slab_nodes = 1;
+  }
+  self->slabs = NULL;
+  self->free_list = NULL;
+  self->fresh = NULL;
+  self->fresh_end = NULL;
+  self->live = 0;
+  self->generation = atomic_fetch_add(&node_pool_generations, 1);
+  self->shared = shared;
+  self->next = NULL;
+  if(shared){
+    pthread_mutex_init(&self->lock, NULL);
+    pthread_mutex_lock(&node_pool_registry_lock);
+    self->next = node_pool_registry;
+    node_pool_registry = self;
+    pthread_mutex_unlock(&node_pool_registry_lock);
+  }
+}
+
+void node_pool_release(struct node_pool *self) {
+  assert(self != NULL);
+  struct node_pool_slab *slab = self->slabs;
+  while(slab != NULL){
+    struct node_pool_slab *next = slab->next;
+    free(slab);
+    slab = next;
+  }
+  self->slabs = NULL;
+  self->free_list = NULL;
+  self->fresh = NULL;
+  self->fresh_end = NULL;
+  self->live = 0;
+  if(self->shared){
+    pthread_mutex_lock(&node_pool_registry_lock);
+  }
+  self->generation = atomic_fetch_add(&node_pool_generations, 1); //les caches des threads sont invalidés
+  if(self->shared){
+    pthread_mutex_unlock(&node_pool_registry_lock);
+  }
+}
+
+void node_pool_destroy(struct node_pool *self) {
+  assert(self != NULL);
+  node_pool_release(self);
+  if(self->shared){
+    pthread_mutex_lock(&node_pool_registry_lock);
+    struct node_pool **link = &node_pool_registry;
+    while(*link != self){
+      link = &(*link)->next;
+    }
+    *link = self->next;
+    pthread_mutex_unlock(&node_pool_registry_lock);
+    pthread_mutex_destroy(&self->lock);
+  }
+}
+
+/*
+ * Prend un noeud dans la liste libre, ou à défaut dans la plaque en cours de découpage
+ */
+static void *node_pool_take(struct node_pool *self) {
+  void *node = self->free_list;
+  if(node != NULL){
+    self->free_list = *(void **)node;
+  }else{
+    if(self->fresh == self->fresh_end){
+      struct node_pool_slab *slab = malloc(sizeof(struct node_pool_slab) + self->slab_nodes * self->node_size);
+      slab->next = self->slabs;
+      self->slabs = slab;
+      self->fresh = slab->nodes;
+      self->fresh_end = slab->nodes + self->slab_nodes * self->node_size;
+    }
+    node = self->fresh;
+    self->fresh += self->node_size;
+  }
+  ++self->live;
+  return node;
+}
+
+static void node_pool_give(struct node_pool *self, void *node) {
+  *(void **)node = self->free_list;
+  self->free_list = node;
+  --self->live;
+}
+
+/*
+ * Rend les noeuds d'un cache à leur pool s'il existe encore avec la même génération
+ */
+static void node_pool_cache_flush(struct node_pool_cache *cache) {
+  if(cache->count == 0){
+    return;
+  }
+  pthread_mutex_lock(&node_pool_registry_lock);
+  for(struct node_pool *pool = node_pool_registry; pool != NULL; pool = pool->next){
+    if(pool->generation == cache->generation){
+      pthread_mutex_lock(&pool->lock);
+      while(cache->count > 0){
+        node_pool_give(pool, cache->nodes[--cache->count]);
+      }
+      pthread_mutex_unlock(&pool->lock);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&node_pool_registry_lock);
+  cache->count = 0;
+}
+
+/*
+ * Cache du thread pour ce pool : un cache vide ou oublié de préférence, sinon chacun son tour
+ */
+static struct node_pool_cache *node_pool_cache_of(const struct node_pool *self) {
+  struct node_pool_cache *free_cache = NULL;
+  for(size_t i = 0; i < NODE_POOL_CACHES; ++i){
+    struct node_pool_cache *cache = &node_pool_caches[i];
+    if(cache->generation == self->generation){
+      return cache;
+    }
+    if((free_cache == NULL)&&(cache->count == 0)){
+      free_cache = cache;
+    }
+  }
+  if(free_cache == NULL){
+    free_cache = &node_pool_caches[node_pool_cache_victim];
+    node_pool_cache_victim = (node_pool_cache_victim + 1) % NODE_POOL_CACHES;
+    node_pool_cache_flush(free_cache);
+  }
+  free_cache->generation = self->generation;
+  return free_cache;
+}
+
+void *node_pool_alloc(struct node_pool *self) {
+  assert(self != NULL);
+  if(!self->shared){
+    return node_pool_take(self);
+  }
+  struct node_pool_cache *cache = node_pool_cache_of(self);
+  if(cache->count == 0){
+    pthread_mutex_lock(&self->lock);
+    while(cache->count < NODE_POOL_CACHE_BATCH){
+      cache->nodes[cache->count++] = node_pool_take(self);
+    }
+    pthread_mutex_unlock(&self->lock);
+  }
+  return cache->nodes[--cache->count];
+}
+
+void node_pool_free(struct node_pool *self, void *node) {
+  assert(self != NULL);
+  assert(node != NULL);
+  if(!self->shared){
+    node_pool_give(self, node);
+    return;
+  }
+  struct node_pool_cache *cache = node_pool_cache_of(self);
+  if(cache->count == NODE_POOL_CACHE_SIZE){
+    pthread_mutex_lock(&self->lock);
+    while(cache->count > NODE_POOL_CACHE_SIZE - NODE_POOL_CACHE_BATCH){
+      node_pool_give(self, cache->nodes[--cache->count]);
+    }
+    pthread_mutex_unlock(&self->lock);
+  }
+  cache->nodes[cache->count++] = node;
+}
+
+
+
+/*
+ * list
+ */
+
+
+
+void list_create(struct list *self) {
+  assert(self != NULL);
+  self->first = NULL;
+  self->last = NULL;
+  self->size = 0;
+  self->pool = NULL;
+}
+
+void list_create_with_pool(struct list *self, struct node_pool *pool) {
+  list_create(self);
+  assert(pool == NULL || pool->node_size >= sizeof(struct list_node));
+  self->pool = pool;
+}
+
+static struct list_node *list_node_alloc(struct list *self) {
+  return (self->pool == NULL) ? malloc(sizeof(struct list_node)) : node_pool_alloc(self->pool);
+}
+
+static void list_node_free(struct list *self, struct list_node *node) {
+  if(self->pool == NULL){
+    free(node);
+  }else{
+    node_pool_free(self->pool, node);
+  }
+}
+
+void list_create_from(struct list *self, const int *other, size_t size) {
+  assert(self != NULL);
+  list_create(self);
+  for(size_t i = 0; i < size; ++i){
+    list_push_back(self, other[i]);
+  }
+}
+
+void list_destroy(struct list *self) {
+  assert(self != NULL);
+  struct node_pool *pool = self->pool;
+  if((pool != NULL)&&(!pool->shared)&&(pool->live == self->size)){ //tous les noeuds du pool sont à nous : on libère les plaques d'un coup
+    node_pool_release(pool);
+    list_create_with_pool(self, pool);
+    return;
+  }
+  while(self->first != NULL){
+    list_pop_back(self);
+  }
+}
+
+bool list_empty(const struct list *self) {
+  assert(self != NULL);
+  return ((self->first == NULL)&&(self->last == NULL));
+}
+
+size_t list_size(const struct list *self) {
+  assert(self != NULL);
+  return self->size;
+}
+
+void list_recount(struct list *self) {
+  assert(self != NULL);
+  size_t size = 0;
+  for(const struct list_node *courant = self->first; courant != NULL; courant = courant->next){
+    ++size;
+  }
+  self->size = size;
+}
+
+bool list_equals(const struct list *self, const int *data, size_t size) {
+  if(list_size(self) != size){
+    return false;
+  }
+  if(size == 0){
+    return true;
+  }
+  struct list_node *courant = self->first;
+  if(courant->data != data[0]){ //on vérifie le cas où ils n'auraient pas la même taille ou les cas où leurs premiers éléments sont différents
+    return false;
+  }
+  courant = courant->next;
+  for(size_t i = 1; i < size; ++i){   //ensuite on va effectuer un parcours où on va regarder chaque éléments un par un
+    if(data[i] != courant->data){
+      return false;
+    }
+    courant = courant->next;
+  }
+  return true;
+}
+
+void list_push_front(struct list *self, int value) {
+  if(list_empty(self)){
+    self->first = list_node_alloc(self); //si la liste est vide on va initialisé self->first et self->last à la même valeur
+    self->first->data = value;
+    self->first->next = NULL;
+    self->first->prev = NULL;
+    self->last = self->first;
+  }else{  
+    struct list_node *push = list_node_alloc(self);  //sinon le prev de self->first devient le nouveau noeud et le next du nouveau noeud  devient self->first
+    push->data = value;
+    self->first->prev = push;
+    push->next = self->first;
+    push->prev = NULL;
+    self->first = push;
+  }
+  ++self->size;
+}
+
+void list_pop_front(struct list *self) {
+  assert(!list_empty(self));
+  --self->size;
+  if(self->first == self->last){        //si la liste à une taille de 1 on va supprimer juste self->first qui est aussi égal à self->last et mettre ses 2 à NULL
+    list_node_free(self, self->first);
+    self->first = NULL;
+    self->last = NULL;
+  }else{
     struct list_node *pop = self->first; //sinon avec un noeud temporaire on va récupérer self->first et self->first devient son next
     self->first = self->first->next;
     self->first->prev = NULL;
-    free(pop);
+    list_node_free(self, pop);
+  }
+}
+
+void list_push_back(struct list *self, int value) {
+  if(list_empty(self)){
+    self->first = list_node_alloc(self);     //si la liste est vide on fait comme dans list_push_front
+    self->first->data = value;
+    self->first->next = NULL;
+    self->first->prev = NULL;
+    self->last = self->first;
+  }else{
+    struct list_node *push = list_node_alloc(self);  //sinon le next de self->last devient le nouveau noeud et le prev du nouveau noeud  devient self->last
+    push->data = value;
+    self->last->next = push;
+    push->prev = self->last;
+    push->next = NULL;
+    self->last = push;
+  }
+  ++self->size;
+}
+
+void list_pop_back(struct list *self) {
+  assert(!list_empty(self));
+  --self->size;
+  if(self->first == self->last){      //si la taille de la liste est égal à 1 on fait comme dans list_pop_front
+    list_node_free(self, self->first);
+    self->first = NULL;
+    self->last = NULL;
+  }else{
+    struct list_node *pop = self->last; //sinon avec un noeud temporaire on va récupérer self->last et self->last devient son prev
+    self->last = self->last->prev;
+    self->last->next = NULL;
+    list_node_free(self, pop);
+  }
+}
+
+
+/*
+ * Noeud situé à l'index (valide), en partant de l'extrémité la plus proche
+ */
+static struct list_node *list_node_at(const struct list *self, size_t index) {
+  assert(index < self->size);
+  struct list_node *courant;
+  if(index < self->size / 2){
+    courant = self->first;
+    for(size_t i = 0; i < index; ++i){
+      courant = courant->next;
+    }
+  }else{
+    courant = self->last;
+    for(size_t i = self->size - 1; i > index; --i){
+      courant = courant->prev;
+    }
+  }
+  return courant;
+}
+
+/*
+ * Insère le noeud avant next, ou à la fin si next est NULL
+ */
+static void list_link_before(struct list *self, struct list_node *next, struct list_node *node) {
+  struct list_node *prev = (next == NULL) ? self->last : next->prev;
+  node->prev = prev;
+  node->next = next;
+  if(prev == NULL){
+    self->first = node;
+  }else{
+    prev->next = node;
+  }
+  if(next == NULL){
+    self->last = node;
+  }else{
+    next->prev = node;
+  }
+  ++self->size;
+}
+
+/*
+ * Retire le noeud de la liste sans le libérer
+ */
+static void list_unlink(struct list *self, struct list_node *node) {
+  if(node->prev == NULL){
+    self->first = node->next;
+  }else{
+    node->prev->next = node->next;
+  }
+  if(node->next == NULL){
+    self->last = node->prev;
+  }else{
+    node->next->prev = node->prev;
+  }
+  --self->size;
+}
+
+void list_insert(struct list *self, int value, size_t index) {
+  assert(index <= list_size(self));
+  struct list_node *elt = list_node_alloc(self);
+  elt->data = value;
+  list_link_before(self, (index == self->size) ? NULL : list_node_at(self, index), elt); //insérer à la taille de la liste revient à insérer à la fin
+}
+
+void list_remove(struct list *self, size_t index) {
+  assert(!list_empty(self));
+  assert(index < list_size(self));
+  struct list_node *pop = list_node_at(self, index);
+  list_unlink(self, pop);
+  list_node_free(self, pop);
+}
+
+int list_get(const struct list *self, size_t index) {
+  if(index >= list_size(self)){    //si l'index n'est pas valide on renvoie 0
+    return 0;
+  }
+  return list_node_at(self, index)->data;
+}
+
+void list_set(struct list *self, size_t index, int value) {
+  if(index < list_size(self)){     //on ne va rien faire si l'index n'est pas valide
+    list_node_at(self, index)->data = value;
+  }
+}
+
+size_t list_search(const struct list *self, int value) {
+  size_t res = 0;
+  struct list_node *courant = self->first;
+  while(courant != NULL){                   //on va effectuer un parcours jusqu'à ce que la data du noeud courant est égal à la value et on incrémente de 1 le res à chaque fois
+    if(courant->data == value){
+      return res;
+    }
+    courant = courant->next;
+    ++res;
+  }
+  return list_size(self);                    //sinon on renvoie la taille de la liste
+}
+
+bool list_is_sorted(const struct list *self) {
+  if(list_empty(self)){                       //si la liste est vide alors elle est triée
+    return true;
+  }
+  struct list_node *courant = self->first;    //sinon on va effectuer un parcours on va regarder si la data du noeud courant est bien inférieur ou égal à la data du noeud courant suivant
+  while(courant->next != NULL){
+    if(courant->data > courant->next->data){
+      return false;
+    }
+    courant = courant->next;
+  }
+  return true;
+}
+
+void list_split(struct list *self, struct list *out1, struct list *out2) {
+  struct list_cursor middle;                //out1 reçoit la première moitié (plus un élément si la taille est impaire)
+  list_cursor_at(&middle, self, (list_size(self) + 1) / 2);
+  list_split_at(&middle, out2);             //on déplace les chaînes de noeuds sans copier les éléments
+  list_concat(out1, self);
+}
+
+/*
+ * Fusion de deux chaînes triées terminées par NULL en ne modifiant que les pointeurs next
+ * (les pointeurs prev sont refaits en une fois par list_relink_prev)
+ */
+static struct list_node *list_merge_chains(struct list_node *lhs, struct list_node *rhs) {
+  struct list_node head;
+  struct list_node *tail = &head;
+  while((lhs != NULL)&&(rhs != NULL)){
+    if(rhs->data < lhs->data){          //à égalité on prend dans lhs pour que le tri soit stable
+      tail->next = rhs;
+      rhs = rhs->next;
+    }else{
+      tail->next = lhs;
+      lhs = lhs->next;
+    }
+    tail = tail->next;
+  }
+  tail->next = (lhs != NULL) ? lhs : rhs;
+  return head.next;
+}
+
+/*
+ * Place la chaîne first à la fin de la liste en refaisant les pointeurs prev
+ */
+static void list_append_chain(struct list *self, struct list_node *first, size_t size) {
+  if(first == NULL){
+    return;
+  }
+  struct list_node *prev = self->last;
+  if(prev == NULL){
+    self->first = first;
+  }else{
+    prev->next = first;
+  }
+  for(struct list_node *courant = first; courant != NULL; courant = courant->next){
+    courant->prev = prev;
+    prev = courant;
+  }
+  self->last = prev;
+  self->size += size;
+}
+
+void list_merge(struct list *self, struct list *in1, struct list *in2) {
+  assert((self->pool == in1->pool)&&(self->pool == in2->pool));
+  size_t size = in1->size + in2->size;
+  struct list_node *chain = list_merge_chains(in1->first, in2->first); //on réutilise les noeuds de in1 et in2
+  list_create_with_pool(in1, in1->pool);
+  list_create_with_pool(in2, in2->pool);
+  list_append_chain(self, chain, size);
+}
+
+/*
+ * Détache la suite croissante (ou strictement décroissante, qu'on retourne) qui commence en *first
+ */
+static struct list_node *list_take_run(struct list_node **first) {
+  struct list_node *run = *first;
+  struct list_node *courant = run;
+  if((courant->next != NULL)&&(courant->next->data < courant->data)){
+    struct list_node *reversed = NULL;  //suite décroissante : on la retourne au fur et à mesure
+    int previous;
+    do{
+      previous = courant->data;
+      struct list_node *next = courant->next;
+      courant->next = reversed;
+      reversed = courant;
+      courant = next;
+    }while((courant != NULL)&&(courant->data < previous));
+    *first = courant;
+    return reversed;
+  }
+  while((courant->next != NULL)&&(courant->next->data >= courant->data)){
+    courant = courant->next;
+  }
+  *first = courant->next;
+  courant->next = NULL;
+  return run;
+}
+
+/*
+ * Tri fusion ascendant sur les suites déjà triées de la liste : runs[k] contient la fusion
+ * d'environ 2^k suites, et chaque nouvelle suite est propagée comme une retenue binaire.
+ * Une liste déjà triée n'a qu'une suite et est triée en un seul parcours.
+ */
+#define LIST_SORT_LEVELS 64
+
+void list_merge_sort(struct list *self) {
+  if(self->size < 2){
+    return;
+  }
+  struct list_node *runs[LIST_SORT_LEVELS] = { NULL };
+  struct list_node *rest = self->first;
+  while(rest != NULL){
+    struct list_node *carry = list_take_run(&rest);
+    size_t k = 0;
+    while(runs[k] != NULL){             //runs[k] contient des éléments plus anciens, on le met donc à gauche
+      carry = list_merge_chains(runs[k], carry);
+      runs[k] = NULL;
+      ++k;
+    }
+    runs[k] = carry;
+  }
+  struct list_node *chain = NULL;
+  for(size_t k = 0; k < LIST_SORT_LEVELS; ++k){
+    if(runs[k] != NULL){
+      chain = list_merge_chains(runs[k], chain);
+    }
+  }
+  size_t size = self->size;
+  list_create_with_pool(self, self->pool);
+  list_append_chain(self, chain, size);
+}
+
+/*
+ * list_cursor
+ */
+
+void list_cursor_begin(struct list_cursor *self, struct list *list) {
+  assert(self != NULL);
+  assert(list != NULL);
+  self->list = list;
+  self->node = list->first;
+  self->index = 0;
+}
+
+void list_cursor_end(struct list_cursor *self, struct list *list) {
+  assert(self != NULL);
+  assert(list != NULL);
+  self->list = list;
+  self->node = NULL;
+  self->index = list->size;
+}
+
+void list_cursor_at(struct list_cursor *self, struct list *list, size_t index) {
+  assert(index <= list_size(list));
+  self->list = list;
+  self->node = (index == list->size) ? NULL : list_node_at(list, index);
+  self->index = index;
+}
+
+bool list_cursor_valid(const struct list_cursor *self) {
+  assert(self != NULL);
+  return self->node != NULL;
+}
+
+void list_cursor_next(struct list_cursor *self) {
+  assert(list_cursor_valid(self));
+  self->node = self->node->next;
+  ++self->index;
+}
+
+void list_cursor_prev(struct list_cursor *self) {
+  assert(self != NULL);
+  if(self->index == 0){                 //pas de position avant le premier élément, le curseur serait incohérent même sans assert
+    fprintf(stderr, "list_cursor: cannot move before the first element\n");
+    abort();
+  }
+  self->node = (self->node == NULL) ? self->list->last : self->node->prev; //depuis la fin on revient sur le dernier élément
+  --self->index;
+}
+
+int list_cursor_get(const struct list_cursor *self) {
+  assert(list_cursor_valid(self));
+  return self->node->data;
+}
+
+void list_cursor_set(struct list_cursor *self, int value) {
+  assert(list_cursor_valid(self));
+  self->node->data = value;
+}
+
+void list_cursor_insert_before(struct list_cursor *self, int value) {
+  assert(self != NULL);
+  struct list_node *elt = list_node_alloc(self->list);
+  elt->data = value;
+  list_link_before(self->list, self->node, elt);
+  ++self->index;                          //l'élément sous le curseur a été décalé d'une place
+}
+
+void list_cursor_erase(struct list_cursor *self) {
+  assert(list_cursor_valid(self));
+  struct list_node *pop = self->node;
+  self->node = pop->next;                //le curseur passe sur l'élément suivant
+  list_unlink(self->list, pop);
+  list_node_free(self->list, pop);
+}
+
+void list_splice(struct list_cursor *self, struct list *other) {
+  assert(self != NULL);
+  assert(self->list != other);
+  assert(self->list->pool == other->pool);
+  if(list_empty(other)){
+    return;
+  }
+  struct list *list = self->list;
+  struct list_node *next = self->node;    //on accroche toute la chaîne de other entre prev et next
+  struct list_node *prev = (next == NULL) ? list->last : next->prev;
+  other->first->prev = prev;
+  other->last->next = next;
+  if(prev == NULL){
+    list->first = other->first;
+  }else{
+    prev->next = other->first;
+  }
+  if(next == NULL){
+    list->last = other->last;
+  }else{
+    next->prev = other->last;
+  }
+  list->size += other->size;
+  self->index += other->size;
+  list_create_with_pool(other, other->pool);
+}
+
+void list_concat(struct list *self, struct list *other) {
+  struct list_cursor end;
+  list_cursor_end(&end, self);
+  list_splice(&end, other);
+}
+
+void list_split_at(struct list_cursor *self, struct list *out) {
+  assert(self != NULL);
+  assert(self->list != out);
+  assert(self->list->pool == out->pool);
+  struct list *list = self->list;
+  struct list_node *first = self->node;
+  if(first == NULL){
+    return;
+  }
+  struct list tail;                       //on détache la chaîne [first, last] dans une liste temporaire
+  tail.first = first;
+  tail.last = list->last;
+  tail.size = list->size - self->index;
+  tail.pool = list->pool;
+  list->last = first->prev;
+  if(list->last == NULL){
+    list->first = NULL;
+  }else{
+    list->last->next = NULL;
+  }
+  first->prev = NULL;
+  list->size = self->index;
+  self->node = NULL;                      //le curseur est maintenant après la fin de la liste
+  list_concat(out, &tail);
+}
+
+
+
+
+/*
+ * ulist
+ */
+
+
+
+/*
+ * Les noeuds sont alloués alignés sur une ligne de cache pour que les ULIST_NODE_SIZE octets
+ * d'un noeud occupent exactement quatre lignes
+ */
+#define ULIST_NODE_ALIGNMENT 64
+
+/*
+ * Un noeud qui descend sous ce remplissage est fusionné avec un voisin s'ils tiennent dans un seul noeud
+ */
+#define ULIST_NODE_MIN_COUNT (ULIST_NODE_CAPACITY / 2)
+
+_Static_assert(sizeof(struct ulist_node) == ULIST_NODE_SIZE, "an unrolled list node must fill ULIST_NODE_SIZE bytes");
+
+static struct ulist_node *ulist_node_create(void) {
+  struct ulist_node *node = aligned_alloc(ULIST_NODE_ALIGNMENT, sizeof(struct ulist_node));
+  node->next = NULL;
+  node->prev = NULL;
+  node->count = 0;
+  return node;
+}
+
+/*
+ * Insère node juste après prev (au début si prev vaut NULL)
+ */
+static void ulist_link_after(struct ulist *self, struct ulist_node *prev, struct ulist_node *node) {
+  struct ulist_node *next = (prev == NULL) ? self->first : prev->next;
+  node->prev = prev;
+  node->next = next;
+  if(prev == NULL){
+    self->first = node;
+  }else{
+    prev->next = node;
+  }
+  if(next == NULL){
+    self->last = node;
+  }else{
+    next->prev = node;
+  }
+}
+
+static void ulist_unlink(struct ulist *self, struct ulist_node *node) {
+  if(node->prev == NULL){
+    self->first = node->next;
+  }else{
+    node->prev->next = node->next;
+  }
+  if(node->next == NULL){
+    self->last = node->prev;
+  }else{
+    node->next->prev = node->prev;
+  }
+  free(node);
+}
+
+/*
+ * Noeud contenant l'élément d'indice index (index < size), on part de l'extrémité la plus proche
+ * en sautant un noeud entier à chaque pas. *offset reçoit la position de l'élément dans le noeud.
+ */
+static struct ulist_node *ulist_node_at(const struct ulist *self, size_t index, size_t *offset) {
+  struct ulist_node *node;
+  if(index < self->size / 2){
+    node = self->first;
+    while(index >= node->count){
+      index -= node->count;
+      node = node->next;
+    }
+  }else{
+    size_t back = self->size - index; //nombre d'éléments depuis l'élément cherché jusqu'à la fin
+    node = self->last;
+    while(back > node->count){
+      back -= node->count;
+      node = node->prev;
+    }
+    index = node->count - back;
+  }
+  *offset = index;
+  return node;
+}
+
+/*
+ * Coupe un noeud plein en deux moitiés et renvoie la seconde
+ */
+static struct ulist_node *ulist_node_split(struct ulist *self, struct ulist_node *node) {
+  struct ulist_node *half = ulist_node_create();
+  unsigned keep = node->count / 2;
+  half->count = node->count - keep;
+  memcpy(half->data, node->data + keep, half->count * sizeof(int));
+  node->count = keep;
+  ulist_link_after(self, node, half);
+  return half;
+}
+
+/*
+ * Après un retrait : libère le noeud s'il est vide, sinon le fusionne avec un voisin s'il est trop peu rempli
+ */
+static void ulist_node_rebalance(struct ulist *self, struct ulist_node *node) {
+  if(node->count == 0){
+    ulist_unlink(self, node);
+    return;
+  }
+  if(node->count >= ULIST_NODE_MIN_COUNT){
+    return;
+  }
+  if((node->next != NULL)&&(node->count + node->next->count <= ULIST_NODE_CAPACITY)){
+    struct ulist_node *next = node->next;
+    memcpy(node->data + node->count, next->data, next->count * sizeof(int));
+    node->count += next->count;
+    ulist_unlink(self, next);
+  }else if((node->prev != NULL)&&(node->prev->count + node->count <= ULIST_NODE_CAPACITY)){
+    struct ulist_node *prev = node->prev;
+    memcpy(prev->data + prev->count, node->data, node->count * sizeof(int));
+    prev->count += node->count;
+    ulist_unlink(self, node);
+  }
+}
+
+void ulist_create(struct ulist *self) {
+  assert(self != NULL);
+  self->first = NULL;
+  self->last = NULL;
+  self->size = 0;
+}
+
+void ulist_create_from(struct ulist *self, const int *other, size_t size) {
+  assert(self != NULL);
+  ulist_create(self);
+  for(size_t i = 0; i < size; i += ULIST_NODE_CAPACITY){ //on remplit les noeuds au maximum
+    struct ulist_node *node = ulist_node_create();
+    node->count = (size - i < ULIST_NODE_CAPACITY) ? size - i : ULIST_NODE_CAPACITY;
+    memcpy(node->data, other + i, node->count * sizeof(int));
+    ulist_link_after(self, self->last, node);
+  }
+  self->size = size;
+}
+
+void ulist_destroy(struct ulist *self) {
+  assert(self != NULL);
+  struct ulist_node *node = self->first;
+  while(node != NULL){
+    struct ulist_node *next = node->next;
+    free(node);
+    node = next;
+  }
+  ulist_create(self);
+}
+
+bool ulist_empty(const struct ulist *self) {
+  assert(self != NULL);
+  return self->size == 0;
+}
+
+size_t ulist_size(const struct ulist *self) {
+  assert(self != NULL);
+  return self->size;
+}
+
+bool ulist_equals(const struct ulist *self, const int *data, size_t size) {
+  assert(self != NULL);
+  if(self->size != size){
+    return false;
+  }
+  for(const struct ulist_node *node = self->first; node != NULL; node = node->next){ //on compare un noeud entier à la fois
+    if(!array_simd.equals(node->data, data, node->count)){
+      return false;
+    }
+    data += node->count;
+  }
+  return true;
+}
+
+void ulist_push_front(struct ulist *self, int value) {
+  assert(self != NULL);
+  struct ulist_node *node = self->first;
+  if((node == NULL)||(node->count == ULIST_NODE_CAPACITY)){
+    node = ulist_node_create();
+    ulist_link_after(self, NULL, node);
+  }
+  memmove(node->data + 1, node->data, node->count * sizeof(int));
+  node->data[0] = value;
+  ++node->count;
+  ++self->size;
+}
+
+void ulist_pop_front(struct ulist *self) {
+  assert(self != NULL);
+  assert(!ulist_empty(self));
+  struct ulist_node *node = self->first;
+  --node->count;
+  memmove(node->data, node->data + 1, node->count * sizeof(int));
+  --self->size;
+  ulist_node_rebalance(self, node);
+}
+
+void ulist_push_back(struct ulist *self, int value) {
+  assert(self != NULL);
+  struct ulist_node *node = self->last;
+  if((node == NULL)||(node->count == ULIST_NODE_CAPACITY)){
+    node = ulist_node_create();
+    ulist_link_after(self, self->last, node);
+  }
+  node->data[node->count++] = value;
+  ++self->size;
+}
+
+void ulist_pop_back(struct ulist *self) {
+  assert(self != NULL);
+  assert(!ulist_empty(self));
+  struct ulist_node *node = self->last;
+  --node->count;
+  --self->size;
+  ulist_node_rebalance(self, node);
+}
+
+void ulist_insert(struct ulist *self, int value, size_t index) {
+  assert(self != NULL);
+  assert(index <= self->size);
+  if(index == self->size){
+    ulist_push_back(self, value);
+    return;
+  }
+  size_t offset;
+  struct ulist_node *node = ulist_node_at(self, index, &offset);
+  if(node->count == ULIST_NODE_CAPACITY){ //noeud plein : on le coupe en deux et on insère dans la bonne moitié
+    struct ulist_node *half = ulist_node_split(self, node);
+    if(offset >= node->count){
+      offset -= node->count;
+      node = half;
+    }
+  }
+  memmove(node->data + offset + 1, node->data + offset, (node->count - offset) * sizeof(int));
+  node->data[offset] = value;
+  ++node->count;
+  ++self->size;
+}
+
+void ulist_remove(struct ulist *self, size_t index) {
+  assert(self != NULL);
+  assert(index < self->size);
+  size_t offset;
+  struct ulist_node *node = ulist_node_at(self, index, &offset);
+  --node->count;
+  memmove(node->data + offset, node->data + offset + 1, (node->count - offset) * sizeof(int));
+  --self->size;
+  ulist_node_rebalance(self, node);
+}
+
+int ulist_get(const struct ulist *self, size_t index) {
+  assert(self != NULL);
+  if(index >= self->size){
+    return 0;
+  }
+  size_t offset;
+  struct ulist_node *node = ulist_node_at(self, index, &offset);
+  return node->data[offset];
+}
+
+void ulist_set(struct ulist *self, size_t index, int value) {
+  assert(self != NULL);
+  if(index >= self->size){
+    return;
+  }
+  size_t offset;
+  struct ulist_node *node = ulist_node_at(self, index, &offset);
+  node->data[offset] = value;
+}
+
+size_t ulist_search(const struct ulist *self, int value) {
+  assert(self != NULL);
+  size_t index = 0;
+  for(const struct ulist_node *node = self->first; node != NULL; node = node->next){ //recherche vectorisée dans chaque noeud
+    size_t pos = array_simd.search(node->data, node->count, value);
+    if(pos < node->count){
+      return index + pos;
+    }
+    index += node->count;
+  }
+  return self->size;
+}
+
+bool ulist_is_sorted(const struct ulist *self) {
+  assert(self != NULL);
+  int prev = INT_MIN;
+  for(const struct ulist_node *node = self->first; node != NULL; node = node->next){
+    for(unsigned i = 0; i < node->count; ++i){
+      if(node->data[i] < prev){
+        return false;
+      }
+      prev = node->data[i];
+    }
+  }
+  return true;
+}
+
+/*
+ * Les éléments sont recopiés dans un tableau où chaque bloc de ULIST_NODE_CAPACITY éléments est trié
+ * par insertion, puis les blocs sont fusionnés deux à deux avec un tampon de même taille (tri stable).
+ * Le résultat est réécrit dans les noeuds existants, sans allocation de noeud.
+ */
+void ulist_merge_sort(struct ulist *self) {
+  assert(self != NULL);
+  size_t size = self->size;
+  if(size < 2){
+    return;
+  }
+  int *data = malloc(2 * size * sizeof(int));
+  int *buffer = data + size;
+  size_t pos = 0;
+  for(const struct ulist_node *node = self->first; node != NULL; node = node->next){
+    memcpy(data + pos, node->data, node->count * sizeof(int));
+    pos += node->count;
+  }
+  for(size_t lo = 0; lo < size; lo += ULIST_NODE_CAPACITY){
+    array_insertion_sort_range(data, lo, (size - lo < ULIST_NODE_CAPACITY) ? size : lo + ULIST_NODE_CAPACITY);
+  }
+  int *src = data;
+  int *dst = buffer;
+  for(size_t width = ULIST_NODE_CAPACITY; width < size; width *= 2){
+    for(size_t lo = 0; lo < size; lo += 2 * width){
+      size_t mid = (size - lo < width) ? size : lo + width;
+      size_t hi = (size - mid < width) ? size : mid + width;
+      array_merge_range(src + lo, mid - lo, src + mid, hi - mid, dst + lo);
+    }
+    int *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  pos = 0;
+  for(struct ulist_node *node = self->first; node != NULL; node = node->next){
+    memcpy(node->data, src + pos, node->count * sizeof(int));
+    pos += node->count;
+  }
+  free(data);
+}
+
+/*
+ * tree
+ */
+
+void tree_create(struct tree *self) {
+  self->root = NULL;
+  self->size = 0;
+  self->pool = NULL;
+  self->blocks = NULL;
+}
+
+void tree_create_with_pool(struct tree *self, struct node_pool *pool) {
+  tree_create(self);
+  assert(pool == NULL || pool->node_size >= sizeof(struct tree_node));
+  self->pool = pool;
+}
+
+static struct tree_node *tree_node_alloc(struct node_pool *pool) {
+  return (pool == NULL) ? malloc(sizeof(struct tree_node)) : node_pool_alloc(pool);
+}
+
+static void tree_node_free(struct node_pool *pool, struct tree_node *node) {
+  if(node->bulk){                               //libéré avec son bloc à la destruction de l'arbre
+    return;
+  }
+  if(pool == NULL){
+    free(node);
+  }else{
+    node_pool_free(pool, node);
+  }
+}
+
+/*
+ * Bloc de noeuds alloués d'un seul coup par une construction en bloc. Un noeud de bloc retiré de l'arbre
+ * n'est pas libéré seul : la mémoire est rendue avec tout le bloc à la destruction de l'arbre.
+ */
+struct tree_block {
+  struct tree_block *next;
+  struct tree_node nodes[];
+};
+
+static void tree_free_blocks(struct tree_block *block){
+  while(block != NULL){
+    struct tree_block *next = block->next;
+    free(block);
+    block = next;
+  }
+}
+
+/*
+ * Destruction sans pile : tant que le noeud courant a un fils gauche, une rotation à droite le fait
+ * remonter, sinon le noeud n'a plus qu'un sous arbre droit et peut être libéré. Chaque rotation
+ * place définitivement un noeud sur la branche droite, il y a donc moins de n rotations.
+ */
+static void tree_node_destroy(struct tree_node *node, struct node_pool *pool){
+  while(node != NULL){
+    if(node->left != NULL){
+      struct tree_node *left = node->left;
+      node->left = left->right;
+      left->right = node;
+      node = left;
+    }else{
+      struct tree_node *right = node->right;
+      tree_node_free(pool, node);
+      node = right;
+    }
+  }
+}
+
+void tree_destroy(struct tree *self) {
+  assert(self != NULL);
+  struct node_pool *pool = self->pool;
+  if(tree_empty(self)){
+    //rien à libérer, sauf les blocs d'une construction en bloc dont tous les noeuds ont été retirés
+  }else if((pool != NULL)&&(!pool->shared)&&(pool->live == self->size)){ //tous les noeuds du pool sont à nous : on libère les plaques d'un coup
+    node_pool_release(pool);
+  }else{
+    tree_node_destroy(self->root, pool);
+  }
+  tree_free_blocks(self->blocks);
+  self->root = NULL;
+  self->size = 0;
+  self->blocks = NULL;
+}
+
+
+
+/*
+ * Rééquilibrage. Les fonctions d'insertion et de suppression descendent sans récursion en gardant
+ * le chemin sous forme de liens (l'adresse du pointeur racine ou du champ left/right du parent) :
+ * une rotation sur un lien remplace directement le sous arbre chez le parent.
+ * Un arbre AVL a une hauteur inférieure à 1.44 log2(n + 2) et un arbre rouge-noir à 2 log2(n + 1),
+ * soit moins de 130 niveaux pour toute taille représentable.
+ */
+#define TREE_PATH_SIZE 132
+
+static size_t tree_node_size(const struct tree_node *node) {
+  return (node == NULL) ? 0 : node->size;
+}
+
+/*
+ * Met à jour les informations d'un noeud calculées depuis ses fils (taille, et hauteur pour un AVL)
+ */
+static void tree_node_update(struct tree_node *node);
+
+static void tree_rotate_left(struct tree_node **link) {
+  struct tree_node *node = *link;
+  struct tree_node *right = node->right;
+  node->right = right->left;
+  right->left = node;
+  *link = right;
+  tree_node_update(node);
+  tree_node_update(right);
+}
+
+static void tree_rotate_right(struct tree_node **link) {
+  struct tree_node *node = *link;
+  struct tree_node *left = node->left;
+  node->left = left->right;
+  left->right = node;
+  *link = left;
+  tree_node_update(node);
+  tree_node_update(left);
+}
+
+#ifdef TREE_RED_BLACK
+
+#define TREE_BLACK 0
+#define TREE_RED 1
+#define TREE_NEW_NODE TREE_RED
+
+static bool tree_is_red(const struct tree_node *node) {
+  return (node != NULL)&&(node->balance == TREE_RED);
+}
+
+static void tree_node_update(struct tree_node *node) {
+  node->size = 1 + tree_node_size(node->left) + tree_node_size(node->right);
+}
+
+/*
+ * Le noeud rouge *path[depth] vient d'être ajouté : on corrige les parents rouges en remontant.
+ * La racine peut rester rouge, tree_insert_fixup la noircit ensuite.
+ */
+static void tree_rb_insert_fixup(struct tree_node **path[], size_t depth) {
+  while(depth >= 2){
+    struct tree_node *parent = *path[depth - 1];
+    if(!tree_is_red(parent)){
+      break;
+    }
+    struct tree_node *grand = *path[depth - 2];   //le parent est rouge donc n'est pas la racine
+    if(parent == grand->left){
+      struct tree_node *uncle = grand->right;
+      if(tree_is_red(uncle)){                     //oncle rouge : on recolore et on recommence deux niveaux plus haut
+        parent->balance = TREE_BLACK;
+        uncle->balance = TREE_BLACK;
+        grand->balance = TREE_RED;
+        depth -= 2;
+        continue;
+      }
+      if(*path[depth] == parent->right){
+        tree_rotate_left(path[depth - 1]);
+        parent = *path[depth - 1];
+      }
+      parent->balance = TREE_BLACK;
+      grand->balance = TREE_RED;
+      tree_rotate_right(path[depth - 2]);
+    }else{
+      struct tree_node *uncle = grand->left;
+      if(tree_is_red(uncle)){
+        parent->balance = TREE_BLACK;
+        uncle->balance = TREE_BLACK;
+        grand->balance = TREE_RED;
+        depth -= 2;
+        continue;
+      }
+      if(*path[depth] == parent->left){
+        tree_rotate_right(path[depth - 1]);
+        parent = *path[depth - 1];
+      }
+      parent->balance = TREE_BLACK;
+      grand->balance = TREE_RED;
+      tree_rotate_left(path[depth - 2]);
+    }
+    break;
+  }
+}
+
+static void tree_insert_fixup(struct tree_node **path[], size_t depth) {
+  tree_rb_insert_fixup(path, depth);
+  (*path[0])->balance = TREE_BLACK;
+}
+
+/*
+ * Un noeud de couleur removed a été retiré à la position *path[depth] : si c'était un noeud noir,
+ * le sous arbre à cette position a un noir de moins qu'il faut rétablir
+ */
+static void tree_remove_fixup(struct tree_node **path[], size_t depth, unsigned char removed) {
+  if(removed == TREE_RED){
+    return;
+  }
+  while((depth > 0)&&(!tree_is_red(*path[depth]))){
+    struct tree_node **link = path[depth - 1];
+    struct tree_node *parent = *link;
+    if(path[depth] == &parent->left){
+      struct tree_node *sibling = parent->right;
+      if(tree_is_red(sibling)){                   //frère rouge : une rotation le remplace par un frère noir, le chemin s'allonge d'un lien
+        sibling->balance = TREE_BLACK;
+        parent->balance = TREE_RED;
+        tree_rotate_left(link);
+        path[depth] = &sibling->left;
+        path[depth + 1] = &parent->left;
+        ++depth;
+        link = path[depth - 1];
+        sibling = parent->right;
+      }
+      if(!tree_is_red(sibling->left)&&!tree_is_red(sibling->right)){
+        sibling->balance = TREE_RED;              //on fait remonter le noir manquant au parent
+        --depth;
+        continue;
+      }
+      if(!tree_is_red(sibling->right)){
+        sibling->left->balance = TREE_BLACK;
+        sibling->balance = TREE_RED;
+        tree_rotate_right(&parent->right);
+        sibling = parent->right;
+      }
+      sibling->balance = parent->balance;
+      parent->balance = TREE_BLACK;
+      sibling->right->balance = TREE_BLACK;
+      tree_rotate_left(link);
+    }else{
+      struct tree_node *sibling = parent->left;
+      if(tree_is_red(sibling)){
+        sibling->balance = TREE_BLACK;
+        parent->balance = TREE_RED;
+        tree_rotate_right(link);
+        path[depth] = &sibling->right;
+        path[depth + 1] = &parent->right;
+        ++depth;
+        link = path[depth - 1];
+        sibling = parent->left;
+      }
+      if(!tree_is_red(sibling->left)&&!tree_is_red(sibling->right)){
+        sibling->balance = TREE_RED;
+        --depth;
+        continue;
+      }
+      if(!tree_is_red(sibling->left)){
+        sibling->right->balance = TREE_BLACK;
+        sibling->balance = TREE_RED;
+        tree_rotate_left(&parent->left);
+        sibling = parent->left;
+      }
+      sibling->balance = parent->balance;
+      parent->balance = TREE_BLACK;
+      sibling->left->balance = TREE_BLACK;
+      tree_rotate_right(link);
+    }
+    return;
+  }
+  if(*path[depth] != NULL){
+    (*path[depth])->balance = TREE_BLACK;
+  }
+}
+
+#else
+
+#define TREE_NEW_NODE 1
+
+static unsigned char tree_avl_height(const struct tree_node *node) {
+  return (node == NULL) ? 0 : node->balance;
+}
+
+static void tree_node_update(struct tree_node *node) {
+  unsigned char left = tree_avl_height(node->left);
+  unsigned char right = tree_avl_height(node->right);
+  node->balance = 1 + ((left > right) ? left : right);
+  node->size = 1 + tree_node_size(node->left) + tree_node_size(node->right);
+}
+
+/*
+ * Rééquilibre le sous arbre *link dont les deux fils sont des arbres AVL de hauteurs différant d'au plus 2
+ */
+static void tree_avl_rebalance(struct tree_node **link) {
+  struct tree_node *node = *link;
+  int diff = tree_avl_height(node->right) - tree_avl_height(node->left);
+  if(diff > 1){
+    if(tree_avl_height(node->right->left) > tree_avl_height(node->right->right)){ //cas droite-gauche : double rotation
+      tree_rotate_right(&node->right);
+    }
+    tree_rotate_left(link);
+  }else if(diff < -1){
+    if(tree_avl_height(node->left->right) > tree_avl_height(node->left->left)){
+      tree_rotate_left(&node->left);
+    }
+    tree_rotate_right(link);
+  }else{
+    tree_node_update(node);
+  }
+}
+
+/*
+ * Le sous arbre *path[depth] a changé de hauteur : on rééquilibre ses ancêtres en remontant,
+ * jusqu'au premier dont la hauteur ne change pas (les tailles ont déjà été mises à jour sur tout le chemin)
+ */
+static void tree_avl_fixup(struct tree_node **path[], size_t depth) {
+  while(depth > 0){
+    --depth;
+    unsigned char height = (*path[depth])->balance;
+    tree_avl_rebalance(path[depth]);
+    if((*path[depth])->balance == height){
+      break;
+    }
+  }
+}
+
+static void tree_insert_fixup(struct tree_node **path[], size_t depth) {
+  tree_avl_fixup(path, depth);
+}
+
+static void tree_remove_fixup(struct tree_node **path[], size_t depth, unsigned char removed) {
+  (void)removed;
+  tree_avl_fixup(path, depth);
+}
+
+#endif
+
+bool tree_contains(const struct tree *self, int value) {
+  assert(self != NULL);
+  struct tree_node *courant = self->root;
+  while((courant != NULL)){              
+    if(courant->data==value){            
+      return true;
+    }
+    if(value < courant->data){
+      courant = courant->left;
+    }else{
+      courant = courant->right;
+    }
+  }
+  return false;
+}
+
+const struct tree_node *tree_insert_or_get(struct tree *self, int value, bool *inserted){
+  assert(self != NULL);
+  struct tree_node **path[TREE_PATH_SIZE];              //path[i] est le lien (racine ou fils) qui mène au noeud de profondeur i
+  size_t depth = 0;
+  path[0] = &self->root;
+  while(*path[depth] != NULL){                          //une seule descente : on s'arrête sur la valeur si elle est déjà présente
+    struct tree_node *courant = *path[depth];
+    if(value == courant->data){
+      if(inserted != NULL){
+        *inserted = false;
+      }
+      return courant;
+    }
+    path[depth + 1] = (value < courant->data) ? &courant->left : &courant->right;
+    ++depth;
+  }
+  struct tree_node *node = tree_node_alloc(self->pool);
+  node->data = value;
+  node->balance = TREE_NEW_NODE;
+  node->bulk = false;
+  node->left = NULL;
+  node->right = NULL;
+  node->size = 1;
+  *path[depth] = node;
+  for(size_t i = 0; i < depth; ++i){                    //chaque ancêtre gagne un noeud
+    ++(*path[i])->size;
+  }
+  tree_insert_fixup(path, depth);                       //les rotations déplacent les liens, pas les noeuds
+  ++self->size;
+  if(inserted != NULL){
+    *inserted = true;
+  }
+  return node;
+}
+
+bool tree_insert(struct tree *self, int value){
+  bool inserted;
+  tree_insert_or_get(self, value, &inserted);
+  return inserted;
+}
+
+bool tree_remove(struct tree *self, int value){
+  assert(self != NULL);
+  struct tree_node **path[TREE_PATH_SIZE];
+  size_t depth = 0;
+  path[0] = &self->root;
+  while((*path[depth] != NULL)&&((*path[depth])->data != value)){ //une seule descente : on s'arrête sur la valeur ou sur un lien vide
+    struct tree_node *courant = *path[depth];
+    path[depth + 1] = (value < courant->data) ? &courant->left : &courant->right;
+    ++depth;
+  }
+  struct tree_node *node = *path[depth];
+  if(node == NULL){
+    return false;
+  }
+  unsigned char removed = node->balance;
+  if((node->left == NULL)||(node->right == NULL)){    //au plus un fils : il prend la place du noeud
+    *path[depth] = (node->left == NULL) ? node->right : node->left;
+  }else{                                              //deux fils : le successeur (minimum du sous arbre droit) prend la place du noeud
+    size_t top = depth;
+    path[++depth] = &node->right;
+    while((*path[depth])->left != NULL){
+      path[depth + 1] = &(*path[depth])->left;
+      ++depth;
+    }
+    struct tree_node *successor = *path[depth];
+    removed = successor->balance;
+    *path[depth] = successor->right;
+    successor->left = node->left;
+    successor->right = node->right;
+    successor->balance = node->balance;
+    successor->size = node->size;
+    *path[top] = successor;
+    path[top + 1] = &successor->right;                //ce lien était dans le noeud supprimé
+  }
+  for(size_t i = 0; i < depth; ++i){                  //chaque noeud du chemin au dessus de la position retirée perd un noeud
+    --(*path[i])->size;
+  }
+  tree_node_free(self->pool, node);
+  tree_remove_fixup(path, depth, removed);
+  --self->size;
+  return true;
+}
+
+bool tree_empty(const struct tree *self) {
+  return (self->root == NULL);
+}
+
+size_t tree_size(const struct tree *self){
+  assert(self != NULL);
+  return self->size;
+}
+
+#ifdef TREE_RED_BLACK
+/*
+ * Parcours en profondeur avec une pile explicite, la pile ne contient jamais plus d'un noeud par niveau
+ */
+static size_t tree_node_height(const struct tree_node *root){
+  const struct tree_node *stack[TREE_PATH_SIZE];
+  size_t depths[TREE_PATH_SIZE];
+  size_t top = 0;
+  size_t height = 0;
+  if(root != NULL){
+    stack[top] = root;
+    depths[top++] = 1;
+  }
+  while(top > 0){
+    const struct tree_node *courant = stack[--top];
+    size_t depth = depths[top];
+    if(depth > height){
+      height = depth;
+    }
+    if(courant->right != NULL){
+      stack[top] = courant->right;
+      depths[top++] = depth + 1;
+    }
+    if(courant->left != NULL){
+      stack[top] = courant->left;
+      depths[top++] = depth + 1;
+    }
+  }
+  return height;
+}
+#endif
+
+size_t tree_height(const struct tree *self) {
+#ifdef TREE_RED_BLACK
+  return tree_node_height(self->root);
+#else
+  return (self->root == NULL) ? 0 : self->root->balance; //la hauteur est maintenue dans chaque noeud
+#endif
+}
+
+size_t tree_rank(const struct tree *self, int value) {
+  assert(self != NULL);
+  size_t rank = 0;
+  const struct tree_node *courant = self->root;
+  while(courant != NULL){
+    if(value <= courant->data){
+      courant = courant->left;
+    }else{                                      //le noeud et tout son sous arbre gauche sont plus petits
+      rank += tree_node_size(courant->left) + 1;
+      courant = courant->right;
+    }
+  }
+  return rank;
+}
+
+/*
+ * Construit l'arbre parfaitement équilibré des size valeurs de data en prenant le milieu comme racine.
+ * Les noeuds sont pris dans l'ordre préfixe du bloc (un noeud est suivi de son fils gauche). Les niveaux
+ * 1 à full sont complets : en rouge-noir, seuls les noeuds du dernier niveau incomplet sont rouges.
+ */
+static struct tree_node *tree_build(struct tree_node **next, const int *data, size_t size, size_t depth, size_t full) {
+  if(size == 0){
+    return NULL;
+  }
+  struct tree_node *node = (*next)++;
+  size_t mid = size / 2;
+  node->data = data[mid];
+  node->bulk = true;
+  node->left = tree_build(next, data, mid, depth + 1, full);
+  node->right = tree_build(next, data + mid + 1, size - mid - 1, depth + 1, full);
+  tree_node_update(node);
+#ifdef TREE_RED_BLACK
+  node->balance = (depth > full) ? TREE_RED : TREE_BLACK;
+#else
+  (void)full;
+#endif
+  return node;
+}
+
+void tree_create_from_sorted(struct tree *self, const int *data, size_t size) {
+  assert(self != NULL);
+  tree_create(self);
+  size_t unique = 0;
+  for(size_t i = 0; i < size; ++i){
+    assert((i == 0)||(data[i - 1] <= data[i]));
+    unique += (i == 0)||(data[i - 1] != data[i]);
+  }
+  if(unique == 0){
+    return;
+  }
+  int *values = NULL;
+  if(unique != size){                           //on ne recopie les valeurs que s'il y a des doublons à enlever
+    values = malloc(unique * sizeof(int));
+    size_t j = 0;
+    for(size_t i = 0; i < size; ++i){
+      if((i == 0)||(data[i - 1] != data[i])){
+        values[j++] = data[i];
+      }
+    }
+    data = values;
+  }
+  self->blocks = malloc(sizeof(struct tree_block) + unique * sizeof(struct tree_node));
+  self->blocks->next = NULL;
+  struct tree_node *next = self->blocks->nodes;
+  self->root = tree_build(&next, data, unique, 1, array_log2(unique + 1));
+  self->size = unique;
+  free(values);
+}
+
+void tree_create_from(struct tree *self, const int *data, size_t size) {
+  assert(self != NULL);
+  struct array sorted;
+  array_create_from(&sorted, data, size);
+  array_radix_sort(&sorted);
+  tree_create_from_sorted(self, sorted.data, sorted.size);
+  array_destroy(&sorted);
+}
+
+int tree_select(const struct tree *self, size_t index) {
+  assert(self != NULL);
+  assert(index < tree_size(self));
+  const struct tree_node *courant = self->root;
+  for(;;){
+    size_t left = tree_node_size(courant->left);
+    if(index == left){
+      return courant->data;
+    }
+    if(index < left){
+      courant = courant->left;
+    }else{
+      index -= left + 1;
+      courant = courant->right;
+    }
+  }
+}
+
+/*
+ * Les parcours utilisent une pile explicite qui ne contient jamais plus d'un noeud par niveau :
+ * TREE_PATH_SIZE noeuds sur la pile d'appel suffisent pour un arbre équilibré. Au delà (arbre
+ * dont les noeuds ont été assemblés à la main), elle passe sur le tas en doublant sa taille.
+ */
+struct tree_stack {
+  const struct tree_node **nodes;
+  size_t top;
+  size_t capacity;
+  const struct tree_node *local[TREE_PATH_SIZE];
+};
+
+static void tree_stack_init(struct tree_stack *self) {
+  self->nodes = self->local;
+  self->top = 0;
+  self->capacity = TREE_PATH_SIZE;
+}
+
+static void tree_stack_destroy(struct tree_stack *self) {
+  if(self->nodes != self->local){
+    free(self->nodes);
+  }
+}
+
+static void tree_stack_push(struct tree_stack *self, const struct tree_node *node) {
+  if(self->top == self->capacity){
+    size_t capacity = 2 * self->capacity;
+    const struct tree_node **nodes = (self->nodes == self->local) ? NULL : self->nodes;
+    nodes = realloc(nodes, capacity * sizeof(const struct tree_node *));
+    if(nodes == NULL){
+      fprintf(stderr, "tree: cannot allocate a stack of %zu nodes\n", capacity);
+      abort();
+    }
+    if(self->nodes == self->local){
+      memcpy(nodes, self->local, self->top * sizeof(const struct tree_node *));
+    }
+    self->nodes = nodes;
+    self->capacity = capacity;
+  }
+  self->nodes[self->top++] = node;
+}
+
+void tree_walk_pre_order(const struct tree *self, tree_func_t func, void *user_data)  {
+  assert(self != NULL);
+  struct tree_stack stack;                        //les sous arbres droits qui restent à parcourir
+  tree_stack_init(&stack);
+  const struct tree_node *courant = self->root;
+  while(courant != NULL){
+    func(courant->data, user_data);
+    if(courant->right != NULL){
+      tree_stack_push(&stack, courant->right);
+    }
+    if(courant->left != NULL){
+      courant = courant->left;
+    }else{
+      courant = (stack.top > 0) ? stack.nodes[--stack.top] : NULL;
+    }
+  }
+  tree_stack_destroy(&stack);
+}
+
+void tree_walk_in_order(const struct tree *self, tree_func_t func, void *user_data) {
+  tree_walk_range(self, INT_MIN, INT_MAX, func, user_data);
+}
+
+void tree_walk_post_order(const struct tree *self, tree_func_t func, void *user_data) {
+  assert(self != NULL);
+  struct tree_stack stack;                        //le chemin depuis la racine jusqu'au noeud courant
+  tree_stack_init(&stack);
+  const struct tree_node *courant = self->root;
+  const struct tree_node *last = NULL;            //le dernier noeud visité, pour savoir si on remonte de la droite
+  while((courant != NULL)||(stack.top > 0)){
+    if(courant != NULL){
+      tree_stack_push(&stack, courant);
+      courant = courant->left;
+    }else{
+      const struct tree_node *parent = stack.nodes[stack.top - 1];
+      if((parent->right != NULL)&&(parent->right != last)){
+        courant = parent->right;
+      }else{
+        func(parent->data, user_data);
+        last = parent;
+        --stack.top;
+      }
+    }
+  }
+  tree_stack_destroy(&stack);
+}
+
+bool tree_visit_range(const struct tree *self, int lo, int hi, tree_visit_t func, void *user_data) {
+  assert(self != NULL);
+  struct tree_stack stack;                        //les ancêtres dont il reste à visiter la valeur et le sous arbre droit
+  tree_stack_init(&stack);
+  const struct tree_node *courant = self->root;
+  while(courant != NULL){                         //descente vers lo : les noeuds plus petits et leur sous arbre gauche sont ignorés
+    if(courant->data < lo){
+      courant = courant->right;
+    }else{
+      tree_stack_push(&stack, courant);
+      courant = courant->left;
+    }
+  }
+  bool complete = true;
+  while(stack.top > 0){
+    courant = stack.nodes[--stack.top];
+    if(courant->data > hi){                       //tout ce qui reste sur la pile est encore plus grand
+      break;
+    }
+    if(!func(courant->data, user_data)){
+      complete = false;
+      break;
+    }
+    for(courant = courant->right; courant != NULL; courant = courant->left){
+      tree_stack_push(&stack, courant);
+    }
+  }
+  tree_stack_destroy(&stack);
+  return complete;
+}
+
+bool tree_visit_in_order(const struct tree *self, tree_visit_t func, void *user_data) {
+  return tree_visit_range(self, INT_MIN, INT_MAX, func, user_data);
+}
+
+struct tree_walk_adapter {
+  tree_func_t func;
+  void *user_data;
+};
+
+static bool tree_walk_adapter_visit(int value, void *user_data) {
+  struct tree_walk_adapter *adapter = user_data;
+  adapter->func(value, adapter->user_data);
+  return true;
+}
+
+void tree_walk_range(const struct tree *self, int lo, int hi, tree_func_t func, void *user_data) {
+  struct tree_walk_adapter adapter = { func, user_data };
+  tree_visit_range(self, lo, hi, tree_walk_adapter_visit, &adapter);
+}
+
+/*
+ * Opérations ensemblistes par découpe et recollement. tree_join recolle deux arbres équilibrés séparés
+ * par un noeud en O(écart de rang), tree_split coupe un arbre autour d'une valeur en O(log n).
+ * L'union, l'intersection et la différence coupent rhs autour de la racine de lhs puis traitent les deux
+ * moitiés en parallèle : O(m log(n/m + 1)) pour des arbres de tailles m <= n. Aucun noeud n'est alloué,
+ * ceux qui ne font pas partie du résultat sont libérés.
+ */
+#ifndef TREE_PARALLEL_THRESHOLD
+#define TREE_PARALLEL_THRESHOLD 65536
+#endif
+
+#ifndef TREE_PARALLEL_MIN_GRAIN
+#define TREE_PARALLEL_MIN_GRAIN 8192
+#endif
+
+/*
+ * Sous arbre accompagné de son rang : sa hauteur pour un AVL, sa hauteur noire pour un rouge-noir.
+ * La hauteur noire n'est pas dans les noeuds, elle est calculée une fois par opération puis suivie
+ * pendant les découpes pour que chaque recollement reste en O(écart de rang).
+ */
+struct tree_part {
+  struct tree_node *root;
+  size_t rank;
+};
+
+static struct tree_part tree_part_of(struct tree_node *root) {
+  struct tree_part part = { root, 0 };
+#ifdef TREE_RED_BLACK
+  for(const struct tree_node *node = root; node != NULL; node = node->left){
+    if(node->balance == TREE_BLACK){
+      ++part.rank;
+    }
+  }
+#else
+  part.rank = tree_avl_height(root);
+#endif
+  return part;
+}
+
+/*
+ * Fils du sous arbre, à lire avant que le recollement ne modifie sa racine
+ */
+static struct tree_part tree_part_child(struct tree_part parent, struct tree_node *child) {
+  struct tree_part part = { child, 0 };
+#ifdef TREE_RED_BLACK
+  part.rank = parent.rank - ((parent.root->balance == TREE_BLACK) ? 1 : 0);
+#else
+  (void)parent;
+  part.rank = tree_avl_height(child);
+#endif
+  return part;
+}
+
+/*
+ * Recolle left, middle et right (toutes les valeurs de left sont inférieures à middle, celles de right supérieures)
+ */
+static struct tree_part tree_join(struct tree_part left, struct tree_node *middle, struct tree_part right) {
+#ifdef TREE_RED_BLACK
+  if(tree_is_red(left.root)){                   //noircir une racine garde un arbre rouge-noir valide
+    left.root->balance = TREE_BLACK;
+    ++left.rank;
+  }
+  if(tree_is_red(right.root)){
+    right.root->balance = TREE_BLACK;
+    ++right.rank;
+  }
+  bool close = (left.rank == right.rank);
+#else
+  bool close = (left.rank <= right.rank + 1)&&(right.rank <= left.rank + 1);
+#endif
+  middle->left = left.root;
+  middle->right = right.root;
+  if(close){
+#ifdef TREE_RED_BLACK
+    middle->balance = TREE_BLACK;
+    tree_node_update(middle);
+    return (struct tree_part){ middle, left.rank + 1 };
+#else
+    tree_node_update(middle);
+    return (struct tree_part){ middle, middle->balance };
+#endif
+  }
+  bool taller_left = (left.rank > right.rank);  //on descend le bord intérieur du plus haut des deux arbres
+  struct tree_part taller = taller_left ? left : right;
+  size_t target = taller_left ? right.rank : left.rank;
+  size_t added = 1 + tree_node_size(taller_left ? right.root : left.root);
+  struct tree_node *root = taller.root;
+#ifdef TREE_RED_BLACK
+  size_t rank = taller.rank;
+#endif
+  struct tree_node **path[TREE_PATH_SIZE];
+  size_t depth = 0;
+  path[0] = &root;
+  for(;;){
+    struct tree_node *node = *path[depth];
+#ifdef TREE_RED_BLACK
+    if(!tree_is_red(node)){                     //jusqu'à un sous arbre noir de même hauteur noire que l'autre arbre
+      if(rank == target){
+        break;
+      }
+      --rank;
+    }
+#else
+    if(tree_avl_height(node) <= target + 1){    //jusqu'à un sous arbre au plus un plus haut que l'autre arbre
+      break;
+    }
+#endif
+    node->size += added;
+    path[depth + 1] = taller_left ? &node->right : &node->left;
+    ++depth;
+  }
+  if(taller_left){
+    middle->left = *path[depth];
+  }else{
+    middle->right = *path[depth];
+  }
+#ifdef TREE_RED_BLACK
+  middle->balance = TREE_RED;
+  tree_node_update(middle);
+  *path[depth] = middle;
+  tree_rb_insert_fixup(path, depth);            //comme si middle venait d'être inséré à cette place
+  if(tree_is_red(root)){                        //la correction a remonté un noir jusqu'à la racine
+    root->balance = TREE_BLACK;
+    ++taller.rank;
+  }
+  return (struct tree_part){ root, taller.rank };
+#else
+  tree_node_update(middle);
+  *path[depth] = middle;
+  tree_insert_fixup(path, depth);               //comme si middle venait d'être inséré à cette place
+  return (struct tree_part){ root, root->balance };
+#endif
+}
+
+/*
+ * Coupe l'arbre en deux arbres de valeurs inférieures et supérieures à value, le noeud de value est détaché dans *found
+ */
+static void tree_split(struct tree_part tree, int value, struct tree_part *lower, struct tree_node **found, struct tree_part *upper) {
+  struct tree_node *node = tree.root;
+  if(node == NULL){
+    *lower = tree;
+    *found = NULL;
+    *upper = tree;
+  }else if(value < node->data){
+    struct tree_part right = tree_part_child(tree, node->right);
+    tree_split(tree_part_child(tree, node->left), value, lower, found, upper);
+    *upper = tree_join(*upper, node, right);
+  }else if(node->data < value){
+    struct tree_part left = tree_part_child(tree, node->left);
+    tree_split(tree_part_child(tree, node->right), value, lower, found, upper);
+    *lower = tree_join(left, node, *lower);
+  }else{
+    *lower = tree_part_child(tree, node->left);
+    *upper = tree_part_child(tree, node->right);
+    *found = node;
+  }
+}
+
+/*
+ * Détache le plus grand noeud de l'arbre dans *last et renvoie le reste
+ */
+static struct tree_part tree_split_last(struct tree_part tree, struct tree_node **last) {
+  struct tree_node *node = tree.root;
+  if(node->right == NULL){
+    *last = node;
+    return tree_part_child(tree, node->left);
+  }
+  struct tree_part left = tree_part_child(tree, node->left);
+  struct tree_part right = tree_split_last(tree_part_child(tree, node->right), last);
+  return tree_join(left, node, right);
+}
+
+/*
+ * Recolle deux arbres sans noeud intermédiaire
+ */
+static struct tree_part tree_join2(struct tree_part left, struct tree_part right) {
+  if(left.root == NULL){
+    return right;
+  }
+  struct tree_node *last;
+  left = tree_split_last(left, &last);
+  return tree_join(left, last, right);
+}
+
+enum tree_set_op {
+  TREE_UNION,
+  TREE_INTERSECTION,
+  TREE_DIFFERENCE,
+};
+
+struct tree_set_job {
+  struct task_pool *tasks;                      //NULL pour tout faire dans le thread appelant
+  struct node_pool *pool;
+  enum tree_set_op op;
+  struct tree_part lhs;
+  struct tree_part rhs;
+  struct tree_part result;
+  size_t grain;
+};
+
+static void tree_set_run(void *arg) {
+  struct tree_set_job *job = arg;
+  struct tree_node *lhs = job->lhs.root;
+  struct tree_node *rhs = job->rhs.root;
+  if((lhs == NULL)||(rhs == NULL)){
+    switch(job->op){
+      case TREE_UNION:
+        job->result = (lhs != NULL) ? job->lhs : job->rhs;
+        break;
+      case TREE_INTERSECTION:
+        tree_node_destroy((lhs != NULL) ? lhs : rhs, job->pool);
+        job->result = tree_part_of(NULL);
+        break;
+      case TREE_DIFFERENCE:
+        tree_node_destroy(rhs, job->pool);
+        job->result = job->lhs;
+        break;
+    }
+    return;
+  }
+  bool parallel = (job->tasks != NULL)&&(lhs->size + rhs->size > job->grain);
+  struct tree_part lower;
+  struct tree_node *found;
+  struct tree_part upper;
+  tree_split(job->rhs, lhs->data, &lower, &found, &upper);
+  struct tree_part empty = tree_part_of(NULL);
+  struct tree_set_job left = { job->tasks, job->pool, job->op, tree_part_child(job->lhs, lhs->left), lower, empty, job->grain };
+  struct tree_set_job right = { job->tasks, job->pool, job->op, tree_part_child(job->lhs, lhs->right), upper, empty, job->grain };
+  if(parallel){
+    struct task task;
+    task_pool_spawn(job->tasks, &task, tree_set_run, &left);
+    tree_set_run(&right);
+    task_pool_join(job->tasks, &task);
+  }else{
+    tree_set_run(&left);
+    tree_set_run(&right);
+  }
+  bool keep = (job->op == TREE_UNION)||((job->op == TREE_INTERSECTION) == (found != NULL));
+  if(found != NULL){                            //doublon de la racine de lhs : on garde celle-ci si besoin
+    tree_node_free(job->pool, found);
+  }
+  if(keep){
+    job->result = tree_join(left.result, lhs, right.result);
+  }else{
+    tree_node_free(job->pool, lhs);
+    job->result = tree_join2(left.result, right.result);
+  }
+}
+
+/*
+ * Les blocs de other passent à self, qui peut maintenant avoir des noeuds de ces blocs
+ */
+static void tree_take_blocks(struct tree *self, struct tree *other) {
+  struct tree_block **link = &self->blocks;
+  while(*link != NULL){
+    link = &(*link)->next;
+  }
+  *link = other->blocks;
+  other->blocks = NULL;
+}
+
+static void tree_set_operation(struct tree *self, struct tree *in1, struct tree *in2, enum tree_set_op op, unsigned threads) {
+  assert(tree_empty(self));
+  assert((self->pool == in1->pool)&&(self->pool == in2->pool));
+  if(threads == 0){
+    threads = (unsigned)task_pool_default_size();
+  }
+  size_t size = in1->size + in2->size;
+  struct tree_set_job job = { NULL, self->pool, op, tree_part_of(in1->root), tree_part_of(in2->root), tree_part_of(NULL), size };
+  struct task_pool tasks;
+  bool parallel = (threads >= 2)&&(size >= TREE_PARALLEL_THRESHOLD)
+    &&((self->pool == NULL)||(self->pool->shared)); //un pool non partagé ne peut pas recevoir de noeuds de plusieurs threads
+  if(parallel){
+    job.grain = size / (8 * (size_t)threads);
+    if(job.grain < TREE_PARALLEL_MIN_GRAIN){
+      job.grain = TREE_PARALLEL_MIN_GRAIN;
+    }
+    task_pool_create(&tasks, threads);
+    job.tasks = &tasks;
+  }
+  tree_set_run(&job);
+  if(parallel){
+    task_pool_destroy(&tasks);
+  }
+#ifdef TREE_RED_BLACK
+  if(job.result.root != NULL){
+    job.result.root->balance = TREE_BLACK;
+  }
+#endif
+  self->root = job.result.root;
+  self->size = tree_node_size(job.result.root);
+  tree_take_blocks(self, in1);
+  tree_take_blocks(self, in2);
+  tree_create_with_pool(in1, in1->pool);
+  tree_create_with_pool(in2, in2->pool);
+}
+
+void tree_union(struct tree *self, struct tree *in1, struct tree *in2, unsigned threads) {
+  tree_set_operation(self, in1, in2, TREE_UNION, threads);
+}
+
+void tree_intersection(struct tree *self, struct tree *in1, struct tree *in2, unsigned threads) {
+  tree_set_operation(self, in1, in2, TREE_INTERSECTION, threads);
+}
+
+void tree_difference(struct tree *self, struct tree *in1, struct tree *in2, unsigned threads) {
+  tree_set_operation(self, in1, in2, TREE_DIFFERENCE, threads);
+}
+
+
+
+/*
+ * btree
+ */
+
+
+
+/*
+ * Les noeuds sont alignés sur une ligne de cache : les clés et l'en-tête occupent exactement deux lignes,
+ * suivies pour un noeud interne de ses BTREE_MAX_KEYS + 1 fils
+ */
+#define BTREE_NODE_ALIGNMENT 64
+
+_Static_assert(offsetof(struct btree_node, children) == BTREE_NODE_SIZE, "the keys and the header of a B-tree node must fill BTREE_NODE_SIZE bytes");
+_Static_assert(BTREE_MAX_KEYS < ARRAY_BLOCK_SIZE && BTREE_NODE_SIZE >= ARRAY_BLOCK_SIZE * sizeof(int), "the keys of a B-tree node are ranked as one block");
+
+static struct btree_node *btree_node_create(bool leaf) {
+  size_t bytes = BTREE_NODE_SIZE + (leaf ? 0 : (BTREE_MAX_KEYS + 1) * sizeof(struct btree_node *));
+  struct btree_node *node = aligned_alloc(BTREE_NODE_ALIGNMENT, bytes);
+  node->count = 0;
+  node->leaf = leaf;
+  return node;
+}
+
+static void btree_node_destroy(struct btree_node *node) {
+  if(!node->leaf){
+    for(size_t i = 0; i <= node->count; ++i){
+      btree_node_destroy(node->children[i]);
+    }
+  }
+  free(node);
+}
+
+/*
+ * Nombre de clés du noeud plus petites que value, c'est à dire la position de value ou du fils où
+ * la chercher. Les clés sont comparées toutes ensemble, sans branchement.
+ */
+static size_t btree_rank(const struct btree_node *node, int value) {
+  return array_simd.count_less(node->keys, node->count, value);
+}
+
+void btree_create(struct btree *self) {
+  assert(self != NULL);
+  self->root = NULL;
+  self->size = 0;
+  self->height = 0;
+}
+
+void btree_destroy(struct btree *self) {
+  assert(self != NULL);
+  if(self->root != NULL){
+    btree_node_destroy(self->root);
+  }
+  btree_create(self);
+}
+
+bool btree_empty(const struct btree *self) {
+  assert(self != NULL);
+  return self->root == NULL;
+}
+
+size_t btree_size(const struct btree *self) {
+  assert(self != NULL);
+  return self->size;
+}
+
+size_t btree_height(const struct btree *self) {
+  assert(self != NULL);
+  return self->height;
+}
+
+bool btree_contains(const struct btree *self, int value) {
+  assert(self != NULL);
+  const struct btree_node *node = self->root;
+  while(node != NULL){
+    size_t i = btree_rank(node, value);
+    if((i < node->count)&&(node->keys[i] == value)){
+      return true;
+    }
+    node = node->leaf ? NULL : node->children[i];
+  }
+  return false;
+}
+
+/*
+ * Coupe le fils plein i en deux noeuds de BTREE_MIN_DEGREE - 1 clés, la clé du milieu remonte dans le parent
+ */
+static void btree_split_child(struct btree_node *parent, size_t i) {
+  struct btree_node *child = parent->children[i];
+  struct btree_node *right = btree_node_create(child->leaf);
+  right->count = BTREE_MIN_DEGREE - 1;
+  memcpy(right->keys, child->keys + BTREE_MIN_DEGREE, (BTREE_MIN_DEGREE - 1) * sizeof(int));
+  if(!child->leaf){
+    memcpy(right->children, child->children + BTREE_MIN_DEGREE, BTREE_MIN_DEGREE * sizeof(struct btree_node *));
   }
+  child->count = BTREE_MIN_DEGREE - 1;
+  memmove(parent->keys + i + 1, parent->keys + i, (parent->count - i) * sizeof(int));
+  memmove(parent->children + i + 2, parent->children + i + 1, (parent->count - i) * sizeof(struct btree_node *));
+  parent->keys[i] = child->keys[BTREE_MIN_DEGREE - 1];
+  parent->children[i + 1] = right;
+  ++parent->count;
 }
 
-void list_push_back(struct list *self, int value) {
-  if(list_empty(self)){
-    self->first = malloc(sizeof(struct list_node));     //si la liste est vide on fait comme dans list_push_front
-    self->first->data = value;
-    self->first->next = NULL;
-    self->first->prev = NULL;
-    self->last = self->first;
-  }else{
-    struct list_node *push = malloc(sizeof(struct list_node));  //sinon le next de self->last devient le nouveau noeud et le prev du nouveau noeud  devient self->last
-    push->data = value;
-    self->last->next = push;
-    push->prev = self->last;
-    push->next = NULL;
-    self->last = push;
+/*
+ * Insertion en une seule descente : tout noeud plein rencontré est coupé avant d'y descendre,
+ * le parent a donc toujours la place d'accueillir la clé qui remonte
+ */
+bool btree_insert(struct btree *self, int value) {
+  assert(self != NULL);
+  if(self->root == NULL){
+    self->root = btree_node_create(true);
+    self->root->keys[0] = value;
+    self->root->count = 1;
+    self->size = 1;
+    self->height = 1;
+    return true;
+  }
+  if(self->root->count == BTREE_MAX_KEYS){      //la racine pleine est coupée : l'arbre grandit par le haut
+    struct btree_node *root = btree_node_create(false);
+    root->children[0] = self->root;
+    btree_split_child(root, 0);
+    self->root = root;
+    ++self->height;
+  }
+  struct btree_node *node = self->root;
+  for(;;){
+    size_t i = btree_rank(node, value);
+    if((i < node->count)&&(node->keys[i] == value)){
+      return false;
+    }
+    if(node->leaf){
+      memmove(node->keys + i + 1, node->keys + i, (node->count - i) * sizeof(int));
+      node->keys[i] = value;
+      ++node->count;
+      ++self->size;
+      return true;
+    }
+    if(node->children[i]->count == BTREE_MAX_KEYS){
+      btree_split_child(node, i);
+      if(node->keys[i] == value){
+        return false;
+      }
+      if(node->keys[i] < value){
+        ++i;
+      }
+    }
+    node = node->children[i];
   }
 }
 
-void list_pop_back(struct list *self) {
-  assert(!list_empty(self));
-  if(list_size(self) == 1){           //si la taille de la liste est égal à 1 on fait comme dans list_pop_front
-    free(self->first);
-    self->first = NULL;
-    self->last = NULL;
-  }else{
-    struct list_node *pop = self->last; //sinon avec un noeud temporaire on va récupérer self->last et self->last devient son prev
-    self->last = self->last->prev;
-    self->last->next = NULL;
-    free(pop);
+/*
+ * Fusionne le fils i, la clé i et le fils i + 1 dans le fils i. Si la racine se retrouve sans clé,
+ * le fils fusionné devient la racine. Renvoie le fils fusionné.
+ */
+static struct btree_node *btree_merge_children(struct btree *self, struct btree_node *node, size_t i) {
+  struct btree_node *left = node->children[i];
+  struct btree_node *right = node->children[i + 1];
+  left->keys[left->count] = node->keys[i];
+  memcpy(left->keys + left->count + 1, right->keys, right->count * sizeof(int));
+  if(!left->leaf){
+    memcpy(left->children + left->count + 1, right->children, (right->count + 1) * sizeof(struct btree_node *));
   }
+  left->count += right->count + 1;
+  free(right);
+  memmove(node->keys + i, node->keys + i + 1, (node->count - i - 1) * sizeof(int));
+  memmove(node->children + i + 1, node->children + i + 2, (node->count - i - 1) * sizeof(struct btree_node *));
+  --node->count;
+  if(node->count == 0){                         //seule la racine peut descendre à zéro clé
+    assert(node == self->root);
+    self->root = left;
+    --self->height;
+    free(node);
+  }
+  return left;
 }
 
-
-void list_insert(struct list *self, int value, size_t index) {
-  assert((int)(index) >= 0);
-  assert(index <= list_size(self));
-  if(index == 0){                                             //si on veut insérer au début on fait list_push_front
-    list_push_front(self, value); 
-  }else if(index == list_size(self)){                         //sinon si on veut insérer à la fin on fait list_push_back
-    list_push_back(self, value);
-  }else{
-    struct list_node *elt = malloc(sizeof(struct list_node)); //sinon on va allouer un nouveau noeud initialisé avec value
-    elt->data = value;
-    struct list_node *courant = self->first;
-    for(size_t i = 1; i < index; ++i){      //puis on va effectuer un parcours pour faire pointer le next du nouveau noeud au noeud que l'on souhaite
-      courant = courant->next;              //le prev du next on va le faire pointer sur nouveau noeud et le next du noeud courant devient le nouveau noeud
-    }
-    elt->next = courant->next;
-    courant->next->prev = elt;
-    elt->prev = courant;
-    courant->next = elt;
+/*
+ * Fait passer une clé du frère gauche (i - 1) au fils i en la faisant tourner par le parent
+ */
+static void btree_borrow_left(struct btree_node *node, size_t i) {
+  struct btree_node *child = node->children[i];
+  struct btree_node *left = node->children[i - 1];
+  memmove(child->keys + 1, child->keys, child->count * sizeof(int));
+  child->keys[0] = node->keys[i - 1];
+  if(!child->leaf){
+    memmove(child->children + 1, child->children, (child->count + 1) * sizeof(struct btree_node *));
+    child->children[0] = left->children[left->count];
   }
+  node->keys[i - 1] = left->keys[left->count - 1];
+  --left->count;
+  ++child->count;
 }
 
-void list_remove(struct list *self, size_t index) {
-  assert(!list_empty(self));
-  assert((int)(index) >= 0);
-  assert(index < list_size(self));
-  if(index == 0){                             //si on veut supprimer au début on fait list_pop_front
-    list_pop_front(self);
-  }else if(index == list_size(self)-1){       //si on veut supprimer à la fin on fait list_pop_back
-    list_pop_back(self);
-  }else{                                      
-    struct list_node *courant = self->first;  //sinon on va allouer un noeud courant pour effectuer un parcours
-    for(size_t i = 1; i < index; ++i){
-      courant = courant->next;
-    }
-    struct list_node *pop = courant->next;    //on va allouer un noeud pour récupérer le noeud que l'on veut supprimer
-    courant->next = pop->next;                //on va modifier le noeud suivant du noeud courant pour qu'il ne pointe plus sur le noeud à supprimer
-    pop->next->prev = courant;                //on fait la même chose avec le noeud suivant du noeud courant
-    free(pop);
+/*
+ * Fait passer une clé du frère droit (i + 1) au fils i en la faisant tourner par le parent
+ */
+static void btree_borrow_right(struct btree_node *node, size_t i) {
+  struct btree_node *child = node->children[i];
+  struct btree_node *right = node->children[i + 1];
+  child->keys[child->count] = node->keys[i];
+  if(!child->leaf){
+    child->children[child->count + 1] = right->children[0];
+    memmove(right->children, right->children + 1, right->count * sizeof(struct btree_node *));
   }
+  node->keys[i] = right->keys[0];
+  memmove(right->keys, right->keys + 1, (right->count - 1) * sizeof(int));
+  --right->count;
+  ++child->count;
 }
 
-int list_get(const struct list *self, size_t index) {
-  if(((int)(index) < 0)||(index >= list_size(self))){    //si l'index n'est pas valide on renvoie 0
-    return 0;
+/*
+ * Avant de descendre dans le fils i, on lui assure au moins BTREE_MIN_DEGREE clés (en empruntant
+ * à un frère ou en fusionnant avec lui) pour qu'il puisse perdre une clé. Renvoie le fils où descendre.
+ */
+static struct btree_node *btree_fill_child(struct btree *self, struct btree_node *node, size_t i) {
+  if(node->children[i]->count >= BTREE_MIN_DEGREE){
+    return node->children[i];
   }
-  if(index == 0){                               //si on recherche le premier élément on renvoie self->first->data
-    return self->first->data;
+  if((i > 0)&&(node->children[i - 1]->count >= BTREE_MIN_DEGREE)){
+    btree_borrow_left(node, i);
+    return node->children[i];
   }
-  struct list_node *courant = self->first->next;  //sinon on va effectuer un parcours pour trouver le noeud situé à l'index
-  for(size_t i = 1; i < index; ++i){
-    courant = courant->next;
+  if((i < node->count)&&(node->children[i + 1]->count >= BTREE_MIN_DEGREE)){
+    btree_borrow_right(node, i);
+    return node->children[i];
   }
-  return courant->data;
+  return btree_merge_children(self, node, (i < node->count) ? i : i - 1);
 }
 
-void list_set(struct list *self, size_t index, int value) {
-  if(((int)(index )>= 0)&&(index < list_size(self))){                    //on ne va rien faire si l'index n'est pas valide
-    if(index == 0){                                               //si on veut modifier le premier éléments on modifie le self->first->data
-      self->first->data = value;
-    }
-    if((index == list_size(self) - 1)||(list_size(self) == 1)){  //si on veut modifier le dernier éléments ou que la liste est de taille 1 alors on modifie le self->last->data
-      self->last->data = value;
+/*
+ * Suppression en une seule descente : chaque noeud où l'on descend a au moins BTREE_MIN_DEGREE clés
+ */
+bool btree_remove(struct btree *self, int value) {
+  assert(self != NULL);
+  struct btree_node *node = self->root;
+  if(node == NULL){
+    return false;
+  }
+  for(;;){
+    size_t i = btree_rank(node, value);
+    if((i < node->count)&&(node->keys[i] == value)){
+      if(node->leaf){
+        memmove(node->keys + i, node->keys + i + 1, (node->count - i - 1) * sizeof(int));
+        --node->count;
+        --self->size;
+        if(node->count == 0){                   //seule une racine feuille peut devenir vide
+          free(node);
+          btree_create(self);
+        }
+        return true;
+      }
+      struct btree_node *left = node->children[i];
+      struct btree_node *right = node->children[i + 1];
+      if(left->count >= BTREE_MIN_DEGREE){      //on remplace la clé par son prédécesseur, qu'on va supprimer à sa place
+        const struct btree_node *pred = left;
+        while(!pred->leaf){
+          pred = pred->children[pred->count];
+        }
+        value = pred->keys[pred->count - 1];
+        node->keys[i] = value;
+        node = left;
+      }else if(right->count >= BTREE_MIN_DEGREE){ //ou par son successeur
+        const struct btree_node *succ = right;
+        while(!succ->leaf){
+          succ = succ->children[0];
+        }
+        value = succ->keys[0];
+        node->keys[i] = value;
+        node = right;
+      }else{                                    //les deux fils sont au minimum : la clé descend dans leur fusion
+        node = btree_merge_children(self, node, i);
+      }
+      continue;
     }
-    struct list_node *courant = self->first->next;               //sinon on va effectuer un parcours un noeud courant pour trouver le noeud à l'index souhaiter puis on va modifier son data
-    for(size_t i = 1; i < index; ++i){
-      courant = courant->next;
+    if(node->leaf){
+      return false;
     }
-    courant->data = value;
+    node = btree_fill_child(self, node, i);
   }
 }
 
-size_t list_search(const struct list *self, int value) {
-  size_t res = 0;
-  struct list_node *courant = self->first;
-  while(courant != NULL){                   //on va effectuer un parcours jusqu'à ce que la data du noeud courant est égal à la value et on incrémente de 1 le res à chaque fois
-    if(courant->data == value){
-      return res;
+static void btree_node_walk_pre_order(const struct btree_node *node, tree_func_t func, void *user_data) {
+  for(size_t i = 0; i < node->count; ++i){
+    func(node->keys[i], user_data);
+  }
+  if(!node->leaf){
+    for(size_t i = 0; i <= node->count; ++i){
+      btree_node_walk_pre_order(node->children[i], func, user_data);
     }
-    courant = courant->next;
-    ++res;
   }
-  return list_size(self);                    //sinon on renvoie la taille de la liste
 }
 
-bool list_is_sorted(const struct list *self) {
-  if(list_empty(self)){                       //si la liste est vide alors elle est triée
-    return true;
-  }
-  struct list_node *courant = self->first;    //sinon on va effectuer un parcours on va regarder si la data du noeud courant est bien inférieur ou égal à la data du noeud courant suivant
-  while(courant->next != NULL){
-    if(courant->data > courant->next->data){
-      return false;
-    }
-    courant = courant->next;
+void btree_walk_pre_order(const struct btree *self, tree_func_t func, void *user_data) {
+  assert(self != NULL);
+  if(self->root != NULL){
+    btree_node_walk_pre_order(self->root, func, user_data);
   }
-  return true;
 }
 
-void list_split(struct list *self, struct list *out1, struct list *out2) {
-  size_t sz1 = list_size(self) / 2;         //on récupère la taille des listes out1 et out2 en effectuant une modification sur la taille de out1  si la taille de self est impair
-  size_t sz2 = sz1;
-  if(list_size(self)%2 == 1){
-    ++sz1;
+static void btree_node_walk_in_order(const struct btree_node *node, tree_func_t func, void *user_data) {
+  for(size_t i = 0; i < node->count; ++i){
+    if(!node->leaf){
+      btree_node_walk_in_order(node->children[i], func, user_data);
+    }
+    func(node->keys[i], user_data);
   }
-  for(size_t i = 0; i < sz1; ++i){  //on va récupérer le premire élément de self, puis le supprimer de la liste et enfin l'ajouter à la fin de out1
-    int data = list_get(self, 0);
-    list_pop_front(self);
-    list_push_back(out1, data);
+  if(!node->leaf){
+    btree_node_walk_in_order(node->children[node->count], func, user_data);
   }
-  for(size_t i = 0; i < sz2; ++i){ //on va récupérer le premire élément de self, puis le supprimer de la liste et enfin l'ajouter à la fin de out2
-    int data = list_get(self, 0);
-    list_pop_front(self);
-    list_push_back(out2, data);
+}
+
+void btree_walk_in_order(const struct btree *self, tree_func_t func, void *user_data) {
+  assert(self != NULL);
+  if(self->root != NULL){
+    btree_node_walk_in_order(self->root, func, user_data);
   }
 }
 
-void list_merge(struct list *self, struct list *in1, struct list *in2) {
-  size_t data;
-  while((in1->first != NULL)||(in2->first != NULL)){ //tant que in1 et in2 ne sont pas vide on va effectuer un parcours dans les 2
-    if(in1->first == NULL){                           //si in1 est vide alors on va récuperer le premier élément de in2, le supprimer de la liste et l'ajouter à la fin de self
-      data = list_get(in2, 0);
-      list_pop_front(in2);
-      list_push_back(self, data);
-    }else if(in2->first == NULL){                     //sinon si in2 est vide alors on va récuperer le premier élément de in1, le supprimer de la liste et l'ajouter à la fin de self
-      data = list_get(in1, 0);
-      list_pop_front(in1);
-      list_push_back(self, data);
-    }else{                                          //sinon on va comparer le premier élément de in1 avec celui de in2 pour récupérer le plus petit, puis le supprimer de la liste et enfin l'ajouter à la fin de self
-      if(in1->first->data < in2->first->data){
-        data = list_get(in1, 0);
-        list_pop_front(in1);
-        list_push_back(self, data);
-      }else{
-        data = list_get(in2, 0);
-        list_pop_front(in2);
-        list_push_back(self, data);
-      }
+static void btree_node_walk_post_order(const struct btree_node *node, tree_func_t func, void *user_data) {
+  if(!node->leaf){
+    for(size_t i = 0; i <= node->count; ++i){
+      btree_node_walk_post_order(node->children[i], func, user_data);
     }
   }
+  for(size_t i = 0; i < node->count; ++i){
+    func(node->keys[i], user_data);
+  }
 }
 
-void list_merge_sort(struct list *self) {
-  if(list_is_sorted(self)){               //si la liste est triée on sort de la fonction
-    return;
-  }
-  if(list_size(self) < 2){               //si la taille est égale à 1 on sort de la fonction
-    return;
+void btree_walk_post_order(const struct btree *self, tree_func_t func, void *user_data) {
+  assert(self != NULL);
+  if(self->root != NULL){
+    btree_node_walk_post_order(self->root, func, user_data);
   }
-  struct list in1;                    //sinon on va séparer self en 2 listes avec list_split
-  struct list in2;
-  list_create(&in1);
-  list_create(&in2);
-  list_split(self, &in1, &in2);
-  list_merge_sort(&in1);            //effectuer récursivement list_merge_sort sur in1 et in2
-  list_merge_sort(&in2);
-  list_merge(self, &in1, &in2);     //puis fusionner avec in1 et in2 trier
-  list_destroy(&in1);               //enfin detruire in1 et in2
-  list_destroy(&in2);
 }
 
+
+
 /*
- * tree
+ * ctree
  */
 
-void tree_create(struct tree *self) {
-  self->root = NULL;
+/*
+ * Chaque bande est un arbre AVL persistant : un noeud publié n'est plus jamais modifié, une écriture recopie
+ * le chemin de la racine au noeud changé puis publie la nouvelle racine d'un coup. Un lecteur suit ainsi
+ * une version cohérente de la bande sans verrou, et un écrivain n'attend jamais les lecteurs.
+ * Les noeuds remplacés ne sont libérés qu'une fois qu'aucun lecteur ne peut plus les voir (récupération par
+ * époques) : un lecteur annonce l'époque globale en entrant, et l'époque n'avance que quand tous les lecteurs
+ * en cours ont annoncé l'époque courante. Un noeud retiré à l'époque e n'est plus visible à l'époque e + 2.
+ */
+#define CTREE_ALIGNMENT 64
+
+struct ctree_node {
+  int data;
+  unsigned char height;
+  struct ctree_node *left;
+  struct ctree_node *right;
+  struct ctree_node *retired;                   //liste des noeuds en attente de libération, jamais lu par les lecteurs
+};
+
+struct ctree_stripe {
+  _Alignas(CTREE_ALIGNMENT) _Atomic(struct ctree_node *) root;
+  atomic_size_t size;
+  pthread_mutex_t lock;                         //pris par les écrivains seulement
+  struct ctree_node *limbo[3];                  //noeuds retirés, rangés par époque modulo 3
+  size_t limbo_epoch[3];
+};
+
+/*
+ * Un emplacement par thread lecteur, partagé par toutes les instances. L'emplacement d'un thread
+ * terminé est repris par le prochain thread qui lit.
+ */
+struct ctree_reader {
+  _Alignas(CTREE_ALIGNMENT) atomic_size_t state; //(époque << 1) | 1 pendant une lecture, 0 sinon
+  atomic_bool used;
+  size_t depth;                                 //lectures imbriquées, par exemple depuis une fonction de parcours
+  struct ctree_reader *next;
+};
+
+static atomic_size_t ctree_epoch;
+static _Atomic(struct ctree_reader *) ctree_readers;
+static pthread_key_t ctree_reader_key;
+static pthread_once_t ctree_reader_once = PTHREAD_ONCE_INIT;
+static _Thread_local struct ctree_reader *ctree_reader_self;
+
+static void ctree_reader_release(void *reader) {
+  atomic_store(&((struct ctree_reader *)reader)->used, false);
 }
 
-void node_destroy(struct tree_node *self){
-  if((self->left == NULL)&&(self->right == NULL)){
-    free(self);
-    self = NULL;
-  }else if(self->left == NULL){
-    struct tree_node *SAD = self->right;
-    
-    node_destroy(SAD);
-    free(self);
-  }else if(self->right == NULL){
-    struct tree_node *SAG = self->left;
-    
-    node_destroy(SAG);
-    free(self);
-  }else{
-    struct tree_node *SAG = self->left;
-    struct tree_node *SAD = self->right;
-    
-    node_destroy(SAG);
-    node_destroy(SAD);
-    free(self);
-  }
+static void ctree_reader_init(void) {
+  pthread_key_create(&ctree_reader_key, ctree_reader_release);
 }
 
-void tree_destroy(struct tree *self) {
-  assert(self != NULL);
-  if(tree_empty(self)){
-    return;
+static struct ctree_reader *ctree_reader_get(void) {
+  struct ctree_reader *self = ctree_reader_self;
+  if(self != NULL){
+    return self;
   }
-  if(tree_size(self) == 1){
-    free(self->root);
-    self->root = NULL;
-    return;
+  pthread_once(&ctree_reader_once, ctree_reader_init);
+  for(self = atomic_load(&ctree_readers); self != NULL; self = self->next){
+    bool used = false;
+    if(atomic_compare_exchange_strong(&self->used, &used, true)){
+      break;
+    }
   }
-  node_destroy(self->root);
-  self->root = NULL;
+  if(self == NULL){
+    self = aligned_alloc(CTREE_ALIGNMENT, sizeof(struct ctree_reader));
+    atomic_init(&self->state, 0);
+    atomic_init(&self->used, true);
+    self->next = atomic_load(&ctree_readers);
+    while(!atomic_compare_exchange_weak(&ctree_readers, &self->next, self)){
+    }
+  }
+  self->depth = 0;
+  pthread_setspecific(ctree_reader_key, self);
+  ctree_reader_self = self;
+  return self;
 }
 
+static struct ctree_reader *ctree_read_lock(void) {
+  struct ctree_reader *self = ctree_reader_get();
+  if(self->depth++ == 0){
+    atomic_store(&self->state, (atomic_load(&ctree_epoch) << 1) | 1);
+    atomic_thread_fence(memory_order_seq_cst);  //l'annonce doit précéder la lecture des racines
+  }
+  return self;
+}
 
+static void ctree_read_unlock(struct ctree_reader *self) {
+  if(--self->depth == 0){
+    atomic_store_explicit(&self->state, 0, memory_order_release);
+  }
+}
 
-bool tree_contains(const struct tree *self, int value) {
-  assert(self != NULL);
-  struct tree_node *courant = self->root;
-  while((courant != NULL)){              
-    if(courant->data==value){            
-      return true;
-    }
-    if(value < courant->data){
-      courant = courant->left;
-    }else{
-      courant = courant->right;
+/*
+ * Passe à l'époque suivante si tous les lecteurs en cours ont vu l'époque courante
+ */
+static void ctree_epoch_advance(void) {
+  size_t epoch = atomic_load(&ctree_epoch);
+  for(struct ctree_reader *reader = atomic_load(&ctree_readers); reader != NULL; reader = reader->next){
+    size_t state = atomic_load(&reader->state);
+    if(((state & 1) != 0)&&((state >> 1) != epoch)){
+      return;
     }
   }
-  return false;
+  atomic_compare_exchange_strong(&ctree_epoch, &epoch, epoch + 1);
 }
 
-struct tree_node *node_insert(struct tree_node *self, int value){
-  if(self == NULL){                                               //si le noeud est nul on va allouer un noeud en initialisant son data à la valeur et son sous arbre gauche et droite à nul
-    struct tree_node *node = malloc(sizeof(struct tree_node));
-    node->left = NULL;
-    node->right = NULL;
-    node->data = value;
-    return node;
-  }
-  if(value < self->data){                                         //si la valeur est plus petite que la valeur du noeud on va insérer dans le sous arbre gauche
-    self->left = node_insert(self->left, value);
-    return self;
-  }
-  if(value > self->data){                                         //si la valeur est plus grande que la valeur du noeud on va insérer dans le sous arbre droit
-    self->right = node_insert(self->right, value);
-    return self;
+/*
+ * Noeuds remplacés par une écriture, du plus récent au plus ancien
+ */
+struct ctree_write {
+  struct ctree_node *retired;
+  struct ctree_node *last;
+};
+
+static void ctree_retire(struct ctree_write *write, struct ctree_node *node) {
+  node->retired = write->retired;
+  write->retired = node;
+  if(write->last == NULL){
+    write->last = node;
   }
-  return self;
 }
 
-bool tree_insert(struct tree *self, int value){
-  if(tree_contains(self, value)){                       //on vérifie si la valeur est déjà présente ou non
-    return false;
+static void ctree_free_retired(struct ctree_node *node) {
+  while(node != NULL){
+    struct ctree_node *next = node->retired;
+    free(node);
+    node = next;
   }
-  self->root = node_insert(self->root, value);          //sinon on va insérer récursivement depuis la racine
-  return true;
 }
 
-struct tree_node *node_delete_minimum(struct tree_node *self, struct tree_node **min){
-  if(self->left == NULL){
-    struct tree_node *right = self->right;
-    self->right = NULL;
-    *min = self;
-    return right;
+static unsigned char ctree_height(const struct ctree_node *node) {
+  return (node == NULL) ? 0 : node->height;
+}
+
+static struct ctree_node *ctree_node_create(struct ctree_node *left, int data, struct ctree_node *right) {
+  struct ctree_node *node = malloc(sizeof(struct ctree_node));
+  unsigned char left_height = ctree_height(left);
+  unsigned char right_height = ctree_height(right);
+  node->data = data;
+  node->height = 1 + ((left_height > right_height) ? left_height : right_height);
+  node->left = left;
+  node->right = right;
+  node->retired = NULL;
+  return node;
+}
+
+/*
+ * Crée un noeud au dessus de deux arbres AVL de hauteurs différant d'au plus 2 en faisant les rotations
+ * nécessaires. Une rotation ne modifie pas les noeuds déplacés : elle en crée des copies et les retire.
+ */
+static struct ctree_node *ctree_balance(struct ctree_write *write, struct ctree_node *left, int data, struct ctree_node *right) {
+  int diff = ctree_height(right) - ctree_height(left);
+  if(diff > 1){
+    ctree_retire(write, right);
+    if(ctree_height(right->left) > ctree_height(right->right)){ //cas droite-gauche : double rotation
+      struct ctree_node *inner = right->left;
+      ctree_retire(write, inner);
+      return ctree_node_create(ctree_node_create(left, data, inner->left), inner->data, ctree_node_create(inner->right, right->data, right->right));
+    }
+    return ctree_node_create(ctree_node_create(left, data, right->left), right->data, right->right);
   }
-  self->left = node_delete_minimum(self->left, min);
-  return self;
+  if(diff < -1){
+    ctree_retire(write, left);
+    if(ctree_height(left->right) > ctree_height(left->left)){
+      struct ctree_node *inner = left->right;
+      ctree_retire(write, inner);
+      return ctree_node_create(ctree_node_create(left->left, left->data, inner->left), inner->data, ctree_node_create(inner->right, data, right));
+    }
+    return ctree_node_create(left->left, left->data, ctree_node_create(left->right, data, right));
+  }
+  return ctree_node_create(left, data, right);
 }
 
-struct tree_node *node_delete(struct tree_node *self){
-  struct tree_node *left = self->left;
-  struct tree_node *right = self->right;
-  free(self);
-  self = NULL;
-  if((left == NULL)&&(right == NULL)){            //si le noeud est une feuille on retourne nul
-    return NULL;
+/*
+ * Renvoie la nouvelle racine, ou node lui même si la valeur est déjà présente
+ */
+static struct ctree_node *ctree_node_insert(struct ctree_write *write, struct ctree_node *node, int value) {
+  if(node == NULL){
+    return ctree_node_create(NULL, value, NULL);
   }
-  if(left == NULL){                               //si le sous arbre gauche est vide on retourne le sous arbre droit
-    return right;
+  if(value < node->data){
+    struct ctree_node *left = ctree_node_insert(write, node->left, value);
+    if(left == node->left){
+      return node;
+    }
+    ctree_retire(write, node);
+    return ctree_balance(write, left, node->data, node->right);
   }
-  if(right == NULL){                              //si le sous arbre droit est vide on retourne le sous arbre gauche
-    return left;
+  if(node->data < value){
+    struct ctree_node *right = ctree_node_insert(write, node->right, value);
+    if(right == node->right){
+      return node;
+    }
+    ctree_retire(write, node);
+    return ctree_balance(write, node->left, node->data, right);
   }
-  right = node_delete_minimum(right, &self);      //si le sous arbre gauche et droit ne sont pas vide les deux on va rechercher les minimum dans le sous arbre droit pour le placer à la place du noeud
-  self->left = left;
-  self->right = right;
-  return self;
+  return node;
 }
 
-struct tree_node *node_remove(struct tree_node *self, int value){
-  if(self == NULL){                                   //si le noeud est null on renvoie null car le parent est une feuille
+static struct ctree_node *ctree_node_remove_min(struct ctree_write *write, struct ctree_node *node, int *min) {
+  ctree_retire(write, node);
+  if(node->left == NULL){
+    *min = node->data;
+    return node->right;
+  }
+  struct ctree_node *left = ctree_node_remove_min(write, node->left, min);
+  return ctree_balance(write, left, node->data, node->right);
+}
+
+/*
+ * Renvoie la nouvelle racine, ou node lui même si la valeur est absente
+ */
+static struct ctree_node *ctree_node_remove(struct ctree_write *write, struct ctree_node *node, int value) {
+  if(node == NULL){
     return NULL;
   }
-  if(value < self->data){                             //si la valeur est plus petite que la valeur du noeud on supprimer dans le sous arbre gauche
-    self->left = node_remove(self->left, value);
-    return self;
+  if(value < node->data){
+    struct ctree_node *left = ctree_node_remove(write, node->left, value);
+    if(left == node->left){
+      return node;
+    }
+    ctree_retire(write, node);
+    return ctree_balance(write, left, node->data, node->right);
   }
-  if(value > self->data){                            //si la valeur est plus grande que la valeur du noeud on va supprimer dans le sous arber droit
-    self->right = node_remove(self->right, value);
-    return self;
+  if(node->data < value){
+    struct ctree_node *right = ctree_node_remove(write, node->right, value);
+    if(right == node->right){
+      return node;
+    }
+    ctree_retire(write, node);
+    return ctree_balance(write, node->left, node->data, right);
+  }
+  ctree_retire(write, node);
+  if(node->left == NULL){
+    return node->right;
   }
-  return node_delete(self);                          //on a atteint la valeur donc on va supprimer le noeud
+  if(node->right == NULL){
+    return node->left;
+  }
+  int min;
+  struct ctree_node *right = ctree_node_remove_min(write, node->right, &min);
+  return ctree_balance(write, node->left, min, right);
 }
 
-bool tree_remove(struct tree *self, int value){
-  assert(!tree_empty(self));
-  if(!tree_contains(self, value)){                    //on vérifie si la valeur est présente ou non
-    return false;
+/*
+ * Publie la nouvelle racine d'une bande puis met les noeuds remplacés en attente. Les noeuds retirés il y a
+ * au moins trois époques, qui partagent la même case, ne sont plus visibles et sont libérés.
+ */
+static void ctree_stripe_publish(struct ctree_stripe *stripe, struct ctree_node *root, struct ctree_write *write) {
+  atomic_store_explicit(&stripe->root, root, memory_order_release);
+  atomic_thread_fence(memory_order_seq_cst);
+  ctree_epoch_advance();
+  size_t epoch = atomic_load(&ctree_epoch);
+  size_t i = epoch % 3;
+  if(stripe->limbo_epoch[i] != epoch){
+    ctree_free_retired(stripe->limbo[i]);
+    stripe->limbo[i] = NULL;
+    stripe->limbo_epoch[i] = epoch;
+  }
+  if(write->last != NULL){
+    write->last->retired = stripe->limbo[i];
+    stripe->limbo[i] = write->retired;
   }
-  self->root = node_remove(self->root, value);        //sinon on va supprimer récursivement depuis la racine
-  return true;
 }
 
-bool tree_empty(const struct tree *self) {
-  return (self->root == NULL);
+/*
+ * La bande d'une valeur est tirée des bits de poids fort de son hachage de Fibonacci : des valeurs
+ * proches, ou régulièrement espacées, tombent dans des bandes différentes et n'ont pas le même verrou
+ */
+static struct ctree_stripe *ctree_stripe_of(const struct ctree *self, int value) {
+  uint32_t hash = (uint32_t)value * UINT32_C(2654435769);
+  return &self->stripes[((uint64_t)hash * CTREE_STRIPES) >> 32];
 }
 
-int node_size(const struct tree_node *self){
-  if(self == NULL){                                         //si le noeud est une feuille on retourne 0
-    return 0;
+void ctree_create(struct ctree *self) {
+  self->stripes = aligned_alloc(CTREE_ALIGNMENT, CTREE_STRIPES * sizeof(struct ctree_stripe));
+  for(size_t i = 0; i < CTREE_STRIPES; ++i){
+    struct ctree_stripe *stripe = &self->stripes[i];
+    atomic_init(&stripe->root, NULL);
+    atomic_init(&stripe->size, 0);
+    pthread_mutex_init(&stripe->lock, NULL);
+    for(size_t j = 0; j < 3; ++j){
+      stripe->limbo[j] = NULL;
+      stripe->limbo_epoch[j] = 0;
+    }
   }
-  return 1 + node_size(self->left) + node_size(self->right);  //on retourne récursivement node_size sur le sous arbre gauche et droit avec plus 1
 }
 
-size_t tree_size(const struct tree *self){
+static void ctree_node_destroy(struct ctree_node *node) {
+  while(node != NULL){                          //même principe que tree_node_destroy
+    if(node->left != NULL){
+      struct ctree_node *left = node->left;
+      node->left = left->right;
+      left->right = node;
+      node = left;
+    }else{
+      struct ctree_node *right = node->right;
+      free(node);
+      node = right;
+    }
+  }
+}
+
+void ctree_destroy(struct ctree *self) {
   assert(self != NULL);
-  return node_size(self->root);
+  for(size_t i = 0; i < CTREE_STRIPES; ++i){
+    struct ctree_stripe *stripe = &self->stripes[i];
+    ctree_node_destroy(atomic_load(&stripe->root));
+    for(size_t j = 0; j < 3; ++j){
+      ctree_free_retired(stripe->limbo[j]);
+    }
+    pthread_mutex_destroy(&stripe->lock);
+  }
+  free(self->stripes);
+  self->stripes = NULL;
 }
 
-size_t tree_height_rec(const struct tree_node *self){
-  if(self == NULL){                                     //si le noeud est une feuille on retourne 0
-    return 0;
+bool ctree_empty(const struct ctree *self) {
+  return ctree_size(self) == 0;
+}
+
+size_t ctree_size(const struct ctree *self) {
+  assert(self != NULL);
+  size_t size = 0;
+  for(size_t i = 0; i < CTREE_STRIPES; ++i){
+    size += atomic_load_explicit(&self->stripes[i].size, memory_order_relaxed);
   }
-  size_t hSAG = tree_height_rec(self->left) + 1;       //on calcule la hauteur du sous arbre gauche plus 1
-  size_t hSAD = tree_height_rec(self->right) + 1;      //on calcule la hauteur du sous arbre droit plus 1
-  if(hSAG >= hSAD){                            //si la hauteur du saous arbre gauche est plus grand on le retourne
-    return hSAG;
-  }                                            //sinon on retourne le sous arbre droit
-  return hSAD;
+  return size;
 }
 
-size_t tree_height(const struct tree *self) {
-  return tree_height_rec(self->root);
+bool ctree_contains(const struct ctree *self, int value) {
+  assert(self != NULL);
+  struct ctree_stripe *stripe = ctree_stripe_of(self, value);
+  struct ctree_reader *reader = ctree_read_lock();
+  const struct ctree_node *courant = atomic_load_explicit(&stripe->root, memory_order_acquire);
+  while((courant != NULL)&&(courant->data != value)){
+    courant = (value < courant->data) ? courant->left : courant->right;
+  }
+  ctree_read_unlock(reader);
+  return courant != NULL;
 }
 
-void node_walk_pre_order(const struct tree_node *self, tree_func_t func, void *user_data){
-  if(self == NULL){
-    return;
+bool ctree_insert(struct ctree *self, int value) {
+  assert(self != NULL);
+  struct ctree_stripe *stripe = ctree_stripe_of(self, value);
+  pthread_mutex_lock(&stripe->lock);
+  struct ctree_node *root = atomic_load_explicit(&stripe->root, memory_order_relaxed); //seul le détenteur du verrou change la racine
+  struct ctree_write write = { NULL, NULL };
+  struct ctree_node *updated = ctree_node_insert(&write, root, value);
+  bool inserted = (updated != root);
+  if(inserted){
+    ctree_stripe_publish(stripe, updated, &write);
+    atomic_fetch_add_explicit(&stripe->size, 1, memory_order_relaxed);
   }
-  func(self->data, user_data);
-  node_walk_pre_order(self->left, func, user_data);
-  node_walk_pre_order(self->right, func, user_data);
+  pthread_mutex_unlock(&stripe->lock);
+  return inserted;
 }
 
-void tree_walk_pre_order(const struct tree *self, tree_func_t func, void *user_data)  {
-  node_walk_pre_order(self->root, func, user_data);
+bool ctree_remove(struct ctree *self, int value) {
+  assert(self != NULL);
+  struct ctree_stripe *stripe = ctree_stripe_of(self, value);
+  pthread_mutex_lock(&stripe->lock);
+  struct ctree_node *root = atomic_load_explicit(&stripe->root, memory_order_relaxed);
+  struct ctree_write write = { NULL, NULL };
+  struct ctree_node *updated = ctree_node_remove(&write, root, value);
+  bool removed = (updated != root);
+  if(removed){
+    ctree_stripe_publish(stripe, updated, &write);
+    atomic_fetch_sub_explicit(&stripe->size, 1, memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&stripe->lock);
+  return removed;
 }
 
-void node_walk_in_order(const struct tree_node *self, tree_func_t func, void *user_data){
-  if(self == NULL){
-    return;
+/*
+ * Parcours infixe d'une bande, la pile contient le noeud courant et ceux qui restent à visiter au dessus.
+ * Un AVL de moins de 2^32 noeuds a une hauteur d'au plus 46.
+ */
+#define CTREE_PATH_SIZE 48
+
+struct ctree_iterator {
+  const struct ctree_node *stack[CTREE_PATH_SIZE];
+  size_t depth;
+};
+
+static void ctree_iterator_descend(struct ctree_iterator *self, const struct ctree_node *node) {
+  while(node != NULL){
+    self->stack[self->depth++] = node;
+    node = node->left;
   }
-  node_walk_in_order(self->left, func, user_data);
-  func(self->data, user_data);
-  node_walk_in_order(self->right, func, user_data);
 }
 
-void tree_walk_in_order(const struct tree *self, tree_func_t func, void *user_data) {
-  node_walk_in_order(self->root, func, user_data);
+static int ctree_iterator_value(const struct ctree_iterator *self) {
+  return self->stack[self->depth - 1]->data;
 }
 
-void node_walk_post_order(const struct tree_node *self, tree_func_t func, void *user_data){
-  if(self == NULL){
-    return;
+static void ctree_iterator_next(struct ctree_iterator *self) {
+  const struct ctree_node *node = self->stack[--self->depth];
+  ctree_iterator_descend(self, node->right);
+}
+
+/*
+ * Tas des parcours de bandes en cours, ordonné par leur valeur courante
+ */
+static void ctree_heap_sift_down(struct ctree_iterator **heap, size_t count, size_t i) {
+  for(;;){
+    size_t smallest = i;
+    size_t left = 2 * i + 1;
+    size_t right = 2 * i + 2;
+    if((left < count)&&(ctree_iterator_value(heap[left]) < ctree_iterator_value(heap[smallest]))){
+      smallest = left;
+    }
+    if((right < count)&&(ctree_iterator_value(heap[right]) < ctree_iterator_value(heap[smallest]))){
+      smallest = right;
+    }
+    if(smallest == i){
+      return;
+    }
+    struct ctree_iterator *tmp = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = tmp;
+    i = smallest;
   }
-  node_walk_post_order(self->left, func, user_data);
-  node_walk_post_order(self->right, func, user_data);
-  func(self->data, user_data);
 }
 
-void tree_walk_post_order(const struct tree *self, tree_func_t func, void *user_data) {
-  node_walk_post_order(self->root, func, user_data);
+/*
+ * Les bandes ne sont pas des intervalles de valeurs : on fusionne leurs parcours infixes avec un tas
+ */
+void ctree_walk_in_order(const struct ctree *self, tree_func_t func, void *user_data) {
+  assert(self != NULL);
+  struct ctree_iterator *iterators = malloc(CTREE_STRIPES * sizeof(struct ctree_iterator));
+  struct ctree_iterator *heap[CTREE_STRIPES];
+  size_t count = 0;
+  struct ctree_reader *reader = ctree_read_lock();
+  for(size_t i = 0; i < CTREE_STRIPES; ++i){
+    iterators[i].depth = 0;
+    ctree_iterator_descend(&iterators[i], atomic_load_explicit(&self->stripes[i].root, memory_order_acquire));
+    if(iterators[i].depth > 0){
+      heap[count++] = &iterators[i];
+    }
+  }
+  for(size_t i = count / 2; i > 0; --i){
+    ctree_heap_sift_down(heap, count, i - 1);
+  }
+  while(count > 0){
+    struct ctree_iterator *first = heap[0];
+    func(ctree_iterator_value(first), user_data);
+    ctree_iterator_next(first);
+    if(first->depth == 0){
+      heap[0] = heap[--count];
+    }
+    ctree_heap_sift_down(heap, count, 0);
+  }
+  ctree_read_unlock(reader);
+  free(iterators);
 }
@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -44,6 +45,16 @@ size_t array_size(const struct array *self);
  */
 bool array_equals(const struct array *self, const int *content, size_t size);
 
+/*
+ * Make sure the array can hold at least capacity elements without reallocating
+ */
+void array_reserve(struct array *self, size_t capacity);
+
+/*
+ * Reduce the capacity of the array to its size
+ */
+void array_shrink_to_fit(struct array *self);
+
 /*
  * Add an element at the end of the array
  */
@@ -81,9 +92,40 @@ size_t array_search(const struct array *self, int value);
 
 /*
  * Search for an element in the sorted array.
+ * If the value is present several times, the index of the first one is returned.
  */
 size_t array_search_sorted(const struct array *self, int value);
 
+/*
+ * Get the index of the first element not less than value in the sorted array, or the size of the array
+ */
+size_t array_lower_bound(const struct array *self, int value);
+
+/*
+ * Get the index of the first element greater than value in the sorted array, or the size of the array
+ */
+size_t array_upper_bound(const struct array *self, int value);
+
+/*
+ * Get the range [*first, *last) of the elements equal to value in the sorted array
+ */
+void array_equal_range(const struct array *self, int value, size_t *first, size_t *last);
+
+/*
+ * Same as array_lower_bound, using interpolation search (faster for uniformly distributed keys)
+ */
+size_t array_lower_bound_interpolation(const struct array *self, int value);
+
+/*
+ * Search for n elements in the sorted array, out[i] receives array_search_sorted(self, keys[i])
+ */
+void array_search_sorted_batch(const struct array *self, const int *keys, size_t n, size_t *out);
+
+/*
+ * Same as array_search_sorted_batch, for keys sorted in ascending order
+ */
+void array_search_sorted_batch_ordered(const struct array *self, const int *keys, size_t n, size_t *out);
+
 /*
  * Tell if the array is sorted
  */
@@ -95,15 +137,35 @@ bool array_is_sorted(const struct array *self);
 ptrdiff_t array_partition(struct array *self, ptrdiff_t i, ptrdiff_t j);
 
 /*
- * Sort the array with quick sort
+ * Sort the array with quick sort (introsort: falls back to heap sort on bad partitions)
  */
 void array_quick_sort(struct array *self);
 
+/*
+ * Sort the array with radix sort (least significant digit first)
+ */
+void array_radix_sort(struct array *self);
+
+/*
+ * Sort the array with several threads (0 for one thread per processor)
+ */
+void array_parallel_sort(struct array *self, unsigned threads);
+
 /*
  * Sort the array with heap sort
  */
 void array_heap_sort(struct array *self);
 
+/*
+ * Sort the array with bottom-up heap sort (fewer comparisons, same O(n log n) worst case)
+ */
+void array_heap_sort_bottom_up(struct array *self);
+
+/*
+ * Rearrange the array into a heap in O(n)
+ */
+void array_heapify(struct array *self);
+
 /*
  * Tell if the array is a heap
  */
@@ -126,15 +188,158 @@ void array_heap_remove_top(struct array *self);
 
 
 
+/*
+ * Read-only copy of a sorted array laid out for fast searches
+ */
+struct array_index {
+  int *data;
+  size_t size;
+  size_t height;
+};
+
+/*
+ * Build a search index from a sorted array (the array is not modified)
+ */
+void array_index_build(struct array_index *self, const struct array *sorted);
+
+/*
+ * Destroy a search index
+ */
+void array_index_destroy(struct array_index *self);
+
+/*
+ * Search for an element in the index and return its index in the sorted array or the size if not present.
+ * If the value is present several times, the index of the first one is returned.
+ */
+size_t array_index_search(const struct array_index *self, int value);
+
+
+
+/*
+ * Priority queue (d-ary heap), the top is the greatest value or the smallest if min is true
+ */
+struct pqueue {
+  struct array heap;
+  bool min;
+};
+
+/*
+ * Create an empty priority queue
+ */
+void pqueue_create(struct pqueue *self, bool min);
+
+/*
+ * Create a priority queue with initial content in O(n)
+ */
+void pqueue_create_from(struct pqueue *self, const int *other, size_t size, bool min);
+
+/*
+ * Destroy a priority queue
+ */
+void pqueue_destroy(struct pqueue *self);
+
+/*
+ * Tell if the priority queue is empty
+ */
+bool pqueue_empty(const struct pqueue *self);
+
+/*
+ * Get the size of the priority queue
+ */
+size_t pqueue_size(const struct pqueue *self);
+
+/*
+ * Get the value at the top of the priority queue
+ */
+int pqueue_top(const struct pqueue *self);
+
+/*
+ * Add a value into the priority queue
+ */
+void pqueue_push(struct pqueue *self, int value);
+
+/*
+ * Remove the top value of the priority queue
+ */
+void pqueue_pop(struct pqueue *self);
+
+/*
+ * Add a value then remove the top value and return it (faster than push followed by pop)
+ */
+int pqueue_push_pop(struct pqueue *self, int value);
+
+/*
+ * Remove the top value and return it then add a value (faster than pop followed by push)
+ */
+int pqueue_replace_top(struct pqueue *self, int value);
+
+
+
+/*
+ * Pool of fixed-size nodes carved from slabs, with a free list. Releasing the pool frees every node
+ * at once in O(number of slabs). A shared pool can be used from several threads: each thread then
+ * keeps a small cache of free nodes per pool and only takes the lock to refill or drain it. The cache
+ * is given back when the thread needs it for another pool. Nodes left in the cache of a thread that
+ * stops using the pool are only reclaimed when the pool is released.
+ */
+struct node_pool {
+  size_t node_size;
+  size_t slab_nodes;
+  void *slabs;
+  void *free_list;
+  char *fresh;
+  char *fresh_end;
+  size_t live;
+  size_t generation;
+  bool shared;
+  pthread_mutex_t lock;
+  struct node_pool *next;
+};
+
+/*
+ * Create an empty pool of nodes of node_size bytes (nodes are aligned on pointers)
+ */
+void node_pool_create(struct node_pool *self, size_t node_size, bool shared);
+
+/*
+ * Destroy a pool and all its nodes
+ */
+void node_pool_destroy(struct node_pool *self);
+
+/*
+ * Free all the nodes of the pool at once, the pool can still be used afterwards
+ */
+void node_pool_release(struct node_pool *self);
+
+/*
+ * Get a node from the pool
+ */
+void *node_pool_alloc(struct node_pool *self);
+
+/*
+ * Give a node back to the pool
+ */
+void node_pool_free(struct node_pool *self, void *node);
+
+
+
 struct list_node {
   int data;
   struct list_node *next;
   struct list_node *prev;
 };
 
+/*
+ * The size is kept up to date by every list function. It comes after first and last so that
+ * their offsets are unchanged: code that links nodes by hand must call list_recount afterwards.
+ * The nodes come from pool, or from malloc when pool is NULL. Lists exchanging nodes (merge,
+ * split, splice, concat) must use the same pool.
+ */
 struct list {
   struct list_node *first;
   struct list_node *last;
+  size_t size;
+  struct node_pool *pool;
 };
 
 /*
@@ -147,6 +352,11 @@ void list_create(struct list *self);
  */
 void list_create_from(struct list *self, const int *other, size_t size);
 
+/*
+ * Create an empty list whose nodes come from a pool of sizeof(struct list_node) bytes nodes
+ */
+void list_create_with_pool(struct list *self, struct node_pool *pool);
+
 /*
  * Destroy a list
  */
@@ -162,6 +372,11 @@ bool list_empty(const struct list *self);
  */
 size_t list_size(const struct list *self);
 
+/*
+ * Recompute the size of a list whose nodes were linked without the list functions
+ */
+void list_recount(struct list *self);
+
 /*
  * Compare the list to an array (data and size)
  */
@@ -234,16 +449,219 @@ void list_merge(struct list *self, struct list *in1, struct list *in2);
  */
 void list_merge_sort(struct list *self);
 
+/*
+ * Position in a list: on an element, or past the end when node is NULL (index is then the size of the list)
+ */
+struct list_cursor {
+  struct list *list;
+  struct list_node *node;
+  size_t index;
+};
+
+/*
+ * Place the cursor on the first element of the list
+ */
+void list_cursor_begin(struct list_cursor *self, struct list *list);
 
+/*
+ * Place the cursor past the end of the list
+ */
+void list_cursor_end(struct list_cursor *self, struct list *list);
 
+/*
+ * Place the cursor on the element at the specified index (or past the end if index is the size)
+ */
+void list_cursor_at(struct list_cursor *self, struct list *list, size_t index);
+
+/*
+ * Tell if the cursor is on an element
+ */
+bool list_cursor_valid(const struct list_cursor *self);
+
+/*
+ * Move the cursor to the next element
+ */
+void list_cursor_next(struct list_cursor *self);
+
+/*
+ * Move the cursor to the previous element (from past the end, to the last element).
+ * The program aborts if the cursor is on the first element.
+ */
+void list_cursor_prev(struct list_cursor *self);
+
+/*
+ * Get the element under the cursor
+ */
+int list_cursor_get(const struct list_cursor *self);
+
+/*
+ * Set the element under the cursor to a new value
+ */
+void list_cursor_set(struct list_cursor *self, int value);
+
+/*
+ * Insert an element before the cursor (at the end if the cursor is past the end), the cursor does not move
+ */
+void list_cursor_insert_before(struct list_cursor *self, int value);
+
+/*
+ * Remove the element under the cursor and move the cursor to the next element
+ */
+void list_cursor_erase(struct list_cursor *self);
+
+/*
+ * Move all the elements of other before the cursor in O(1). At the end, other should be empty.
+ */
+void list_splice(struct list_cursor *self, struct list *other);
+
+/*
+ * Move all the elements of other at the end of the list in O(1). At the end, other should be empty.
+ */
+void list_concat(struct list *self, struct list *other);
+
+/*
+ * Move the elements from the cursor to the end of the list at the end of out in O(1).
+ * At the end, the cursor is past the end of its list.
+ */
+void list_split_at(struct list_cursor *self, struct list *out);
+
+
+
+/*
+ * Unrolled list: each node stores up to ULIST_NODE_CAPACITY elements and fills ULIST_NODE_SIZE bytes
+ * (four cache lines). Every node holds at least one element.
+ */
+#define ULIST_NODE_SIZE 256
+#define ULIST_NODE_CAPACITY ((ULIST_NODE_SIZE - 2 * sizeof(void *) - sizeof(unsigned)) / sizeof(int))
+
+struct ulist_node {
+  struct ulist_node *next;
+  struct ulist_node *prev;
+  unsigned count;
+  int data[ULIST_NODE_CAPACITY];
+};
+
+struct ulist {
+  struct ulist_node *first;
+  struct ulist_node *last;
+  size_t size;
+};
+
+/*
+ * Create an empty unrolled list
+ */
+void ulist_create(struct ulist *self);
+
+/*
+ * Create an unrolled list with initial content
+ */
+void ulist_create_from(struct ulist *self, const int *other, size_t size);
+
+/*
+ * Destroy an unrolled list
+ */
+void ulist_destroy(struct ulist *self);
+
+/*
+ * Tell if the unrolled list is empty
+ */
+bool ulist_empty(const struct ulist *self);
+
+/*
+ * Get the size of the unrolled list
+ */
+size_t ulist_size(const struct ulist *self);
+
+/*
+ * Compare the unrolled list to an array (data and size)
+ */
+bool ulist_equals(const struct ulist *self, const int *data, size_t size);
+
+/*
+ * Add an element in the unrolled list at the beginning
+ */
+void ulist_push_front(struct ulist *self, int value);
+
+/*
+ * Remove the element at the beginning of the unrolled list
+ */
+void ulist_pop_front(struct ulist *self);
+
+/*
+ * Add an element in the unrolled list at the end
+ */
+void ulist_push_back(struct ulist *self, int value);
+
+/*
+ * Remove the element at the end of the unrolled list
+ */
+void ulist_pop_back(struct ulist *self);
+
+/*
+ * Insert an element in the unrolled list (preserving the order)
+ * index is valid or equals to the size of the list (insert at the end)
+ */
+void ulist_insert(struct ulist *self, int value, size_t index);
+
+/*
+ * Remove an element in the unrolled list (preserving the order)
+ * index is valid
+ */
+void ulist_remove(struct ulist *self, size_t index);
+
+/*
+ * Get the element at the specified index in the unrolled list or 0 if the index is not valid
+ */
+int ulist_get(const struct ulist *self, size_t index);
+
+/*
+ * Set an element at the specified index in the unrolled list to a new value, or do nothing if the index is not valid
+ */
+void ulist_set(struct ulist *self, size_t index, int value);
+
+/*
+ * Search for an element in the unrolled list and return its index or the size of the list if not present.
+ */
+size_t ulist_search(const struct ulist *self, int value);
+
+/*
+ * Tell if an unrolled list is sorted
+ */
+bool ulist_is_sorted(const struct ulist *self);
+
+/*
+ * Sort an unrolled list with merge sort
+ */
+void ulist_merge_sort(struct ulist *self);
+
+
+
+/*
+ * The tree is balanced: an AVL tree by default, or a red-black tree when the library is built
+ * with TREE_RED_BLACK defined. balance holds the height of the subtree (AVL) or the colour,
+ * 1 for red (red-black). size is the number of nodes in the subtree. bulk tells that the node was
+ * allocated with others in a block owned by the tree, it is freed with its block when the tree is destroyed.
+ */
 struct tree_node {
   int data;
+  unsigned char balance;
+  bool bulk;
   struct tree_node *left;
   struct tree_node *right;
+  size_t size;
 };
 
+/*
+ * The nodes come from pool, or from malloc when pool is NULL, except the nodes built in bulk
+ * which come from the blocks of the tree
+ */
+struct tree_block;
+
 struct tree {
   struct tree_node *root;
+  size_t size;
+  struct node_pool *pool;
+  struct tree_block *blocks;
 };
 
 /*
@@ -251,6 +669,22 @@ struct tree {
  */
 void tree_create(struct tree *self);
 
+/*
+ * Create an empty tree whose nodes come from a pool of sizeof(struct tree_node) bytes nodes
+ */
+void tree_create_with_pool(struct tree *self, struct node_pool *pool);
+
+/*
+ * Create a perfectly balanced tree from sorted values (duplicates are ignored) in O(n).
+ * The nodes are allocated in a single block.
+ */
+void tree_create_from_sorted(struct tree *self, const int *data, size_t size);
+
+/*
+ * Create a tree from values in any order by sorting them then building the tree in bulk
+ */
+void tree_create_from(struct tree *self, const int *data, size_t size);
+
 /*
  * Create a tree
  */
@@ -281,11 +715,29 @@ bool tree_contains(const struct tree *self, int value);
  */
 bool tree_insert(struct tree *self, int value);
 
+/*
+ * Insert a value in the tree if it is not present and return the node holding it. inserted (if not NULL)
+ * tells if the value was added. The node stays valid until the value is removed from the tree and must
+ * not be modified.
+ */
+const struct tree_node *tree_insert_or_get(struct tree *self, int value, bool *inserted);
+
 /*
  * Remove a value from the tree and return false if the value was not present
  */
 bool tree_remove(struct tree *self, int value);
 
+/*
+ * Get the number of values in the tree that are lower than value
+ */
+size_t tree_rank(const struct tree *self, int value);
+
+/*
+ * Get the value at the specified index in the sorted order of the tree
+ * index is valid
+ */
+int tree_select(const struct tree *self, size_t index);
+
 /*
  * A function type that takes an int and a pointer and returns void
  */
@@ -306,6 +758,181 @@ void tree_walk_in_order(const struct tree *self, tree_func_t func, void *user_da
  */
 void tree_walk_post_order(const struct tree *self, tree_func_t func, void *user_data);
 
+/*
+ * Walk in order through the values between lo and hi (included) and call the function with user_data as a second argument.
+ * The subtrees outside the range are not visited.
+ */
+void tree_walk_range(const struct tree *self, int lo, int hi, tree_func_t func, void *user_data);
+
+/*
+ * A function type that takes an int and a pointer and returns false to stop the walk
+ */
+typedef bool (*tree_visit_t)(int value, void *user_data);
+
+/*
+ * Walk in the tree in in order and call the function with user_data as a second argument until it returns false.
+ * Return false if the walk was stopped.
+ */
+bool tree_visit_in_order(const struct tree *self, tree_visit_t func, void *user_data);
+
+/*
+ * Walk in order through the values between lo and hi (included) and call the function with user_data as a second argument
+ * until it returns false. Return false if the walk was stopped.
+ */
+bool tree_visit_range(const struct tree *self, int lo, int hi, tree_visit_t func, void *user_data);
+
+/*
+ * Compute the union of two trees in an empty tree, with several threads (0 for one thread per processor).
+ * The nodes are reused, the trees must have the same pool. At the end, in1 and in2 should be empty.
+ */
+void tree_union(struct tree *self, struct tree *in1, struct tree *in2, unsigned threads);
+
+/*
+ * Compute the intersection of two trees in an empty tree, like tree_union
+ */
+void tree_intersection(struct tree *self, struct tree *in1, struct tree *in2, unsigned threads);
+
+/*
+ * Compute the values of in1 that are not in in2 in an empty tree, like tree_union
+ */
+void tree_difference(struct tree *self, struct tree *in1, struct tree *in2, unsigned threads);
+
+
+
+/*
+ * B-tree set of minimum degree BTREE_MIN_DEGREE: every node but the root holds between
+ * BTREE_MIN_DEGREE - 1 and BTREE_MAX_KEYS sorted keys. The keys and the header of a node fill
+ * BTREE_NODE_SIZE bytes (two cache lines) and are compared with SIMD instructions when available.
+ * The children of an internal node follow its keys.
+ */
+#define BTREE_MIN_DEGREE 16
+#define BTREE_MAX_KEYS (2 * BTREE_MIN_DEGREE - 1)
+#define BTREE_NODE_SIZE 128
+
+struct btree_node {
+  int keys[BTREE_MAX_KEYS];
+  unsigned short count;
+  bool leaf;
+  struct btree_node *children[];
+};
+
+struct btree {
+  struct btree_node *root;
+  size_t size;
+  size_t height;
+};
+
+/*
+ * Create an empty B-tree
+ */
+void btree_create(struct btree *self);
+
+/*
+ * Destroy a B-tree
+ */
+void btree_destroy(struct btree *self);
+
+/*
+ * Tell if the B-tree is empty
+ */
+bool btree_empty(const struct btree *self);
+
+/*
+ * Get the size of the B-tree
+ */
+size_t btree_size(const struct btree *self);
+
+/*
+ * Get the height of the B-tree (all the leaves are at the same depth)
+ */
+size_t btree_height(const struct btree *self);
+
+/*
+ * Tell if a value is in the B-tree
+ */
+bool btree_contains(const struct btree *self, int value);
+
+/*
+ * Insert a value in the B-tree and return false if the value was already present
+ */
+bool btree_insert(struct btree *self, int value);
+
+/*
+ * Remove a value from the B-tree and return false if the value was not present
+ */
+bool btree_remove(struct btree *self, int value);
+
+/*
+ * Walk in the B-tree in pre order (the keys of a node, then its children) and call the function with user_data as a second argument
+ */
+void btree_walk_pre_order(const struct btree *self, tree_func_t func, void *user_data);
+
+/*
+ * Walk in the B-tree in in order and call the function with user_data as a second argument
+ */
+void btree_walk_in_order(const struct btree *self, tree_func_t func, void *user_data);
+
+/*
+ * Walk in the B-tree in post order (the children of a node, then its keys) and call the function with user_data as a second argument
+ */
+void btree_walk_post_order(const struct btree *self, tree_func_t func, void *user_data);
+
+
+
+/*
+ * Concurrent set of integers. The values are spread over CTREE_STRIPES balanced trees by a hash, so
+ * that close values are in different trees. ctree_contains, ctree_size and the walks take no lock and
+ * can run at any time from any thread; ctree_insert and ctree_remove lock the tree of their value only.
+ * A walk sees each tree of the set as it was when the walk started.
+ */
+#define CTREE_STRIPES 64
+
+struct ctree_stripe;
+
+struct ctree {
+  struct ctree_stripe *stripes;
+};
+
+/*
+ * Create an empty concurrent tree
+ */
+void ctree_create(struct ctree *self);
+
+/*
+ * Destroy a concurrent tree, no other thread may use it anymore
+ */
+void ctree_destroy(struct ctree *self);
+
+/*
+ * Tell if the concurrent tree is empty
+ */
+bool ctree_empty(const struct ctree *self);
+
+/*
+ * Get the size of the concurrent tree
+ */
+size_t ctree_size(const struct ctree *self);
+
+/*
+ * Tell if a value is in the concurrent tree
+ */
+bool ctree_contains(const struct ctree *self, int value);
+
+/*
+ * Insert a value in the concurrent tree and return false if the value was already present
+ */
+bool ctree_insert(struct ctree *self, int value);
+
+/*
+ * Remove a value from the concurrent tree and return false if the value was not present
+ */
+bool ctree_remove(struct ctree *self, int value);
+
+/*
+ * Walk in the concurrent tree in in order and call the function with user_data as a second argument
+ */
+void ctree_walk_in_order(const struct ctree *self, tree_func_t func, void *user_data);
+
 
 #ifdef __cplusplus
 }
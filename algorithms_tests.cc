@@ -1,10 +1,18 @@
 #include "gtest/gtest.h"
 
 #include <cassert>
+#include <climits>
 #include <cstdlib>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
 
 #include "algorithms.h"
 
@@ -94,6 +102,123 @@ TEST(ArrayEqualsTest, SizeLarger) {
   array_destroy(&a);
 }
 
+TEST(ArrayEqualsTest, Stressed) {
+  std::vector<int> origin;
+
+  for (int i = 0; i < 100; ++i) {
+    origin.push_back(i * 7);
+  }
+
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
+
+  for (std::size_t size = 0; size <= origin.size(); ++size) {
+    a.size = size;
+    EXPECT_TRUE(array_equals(&a, origin.data(), size));
+
+    for (std::size_t i = 0; i < size; ++i) {
+      std::vector<int> reference(origin.begin(), origin.begin() + size);
+      reference[i] = -1;
+      EXPECT_FALSE(array_equals(&a, reference.data(), size));
+    }
+  }
+
+  array_destroy(&a);
+}
+
+/*
+ * array_reserve
+ */
+
+TEST(ArrayReserveTest, Grow) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
+
+  array_reserve(&a, BIG_SIZE);
+
+  EXPECT_GE(a.capacity, static_cast<std::size_t>(BIG_SIZE));
+  EXPECT_TRUE(array_equals(&a, origin, std::size(origin)));
+
+  int *data = a.data;
+
+  for (int i = 0; i < BIG_SIZE - static_cast<int>(std::size(origin)); ++i) {
+    array_push_back(&a, i);
+  }
+
+  EXPECT_EQ(a.data, data);
+  EXPECT_EQ(array_size(&a), static_cast<std::size_t>(BIG_SIZE));
+
+  array_destroy(&a);
+}
+
+TEST(ArrayReserveTest, Smaller) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
+
+  std::size_t capacity = a.capacity;
+  array_reserve(&a, 1);
+
+  EXPECT_EQ(a.capacity, capacity);
+  EXPECT_TRUE(array_equals(&a, origin, std::size(origin)));
+
+  array_destroy(&a);
+}
+
+TEST(ArrayReserveDeathTest, TooBig) {
+  struct array a;
+  array_create(&a);
+
+  EXPECT_DEATH(array_reserve(&a, SIZE_MAX), "cannot allocate");
+
+  array_destroy(&a);
+}
+
+/*
+ * array_shrink_to_fit
+ */
+
+TEST(ArrayShrinkToFitTest, ManyElements) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct array a;
+  array_create(&a);
+  array_reserve(&a, BIG_SIZE);
+
+  for (int val : origin) {
+    array_push_back(&a, val);
+  }
+
+  array_shrink_to_fit(&a);
+
+  EXPECT_EQ(a.capacity, std::size(origin));
+  EXPECT_TRUE(array_equals(&a, origin, std::size(origin)));
+
+  array_push_back(&a, 10);
+  EXPECT_EQ(array_get(&a, std::size(origin)), 10);
+
+  array_destroy(&a);
+}
+
+TEST(ArrayShrinkToFitTest, Empty) {
+  struct array a;
+  array_create(&a);
+  array_reserve(&a, BIG_SIZE);
+
+  array_shrink_to_fit(&a);
+
+  EXPECT_TRUE(array_empty(&a));
+  EXPECT_LE(a.capacity, 1u);
+
+  array_push_back(&a, 1);
+  EXPECT_EQ(array_get(&a, 0), 1);
+
+  array_destroy(&a);
+}
+
 /*
  * array_push_back
  */
@@ -193,6 +318,27 @@ TEST(ArrayPopBackTest, ManyElements) {
   array_destroy(&a);
 }
 
+TEST(ArrayPopBackTest, Stressed) {
+  struct array a;
+  array_create(&a);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    array_push_back(&a, i);
+  }
+
+  for (int i = BIG_SIZE - 1; i >= 0; --i) {
+    EXPECT_EQ(array_get(&a, i), i);
+    array_pop_back(&a);
+    EXPECT_EQ(array_size(&a), static_cast<std::size_t>(i));
+    EXPECT_LE(array_size(&a), a.capacity);
+  }
+
+  EXPECT_TRUE(array_empty(&a));
+  EXPECT_LT(a.capacity, static_cast<std::size_t>(BIG_SIZE));
+
+  array_destroy(&a);
+}
+
 /*
  * array_insert
  */
@@ -306,6 +452,28 @@ TEST(ArrayRemoveTest, End) {
   array_destroy(&a);
 }
 
+TEST(ArrayRemoveTest, Stressed) {
+  struct array a;
+  array_create(&a);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    array_push_back(&a, i);
+  }
+
+  for (int i = 0; i < BIG_SIZE / 2; ++i) {
+    array_remove(&a, 0);
+    EXPECT_EQ(array_get(&a, 0), i + 1);
+  }
+
+  EXPECT_EQ(array_size(&a), static_cast<std::size_t>(BIG_SIZE / 2));
+
+  for (int i = 0; i < BIG_SIZE / 2; ++i) {
+    EXPECT_EQ(array_get(&a, i), BIG_SIZE / 2 + i);
+  }
+
+  array_destroy(&a);
+}
+
 /*
  * array_get
  */
@@ -403,6 +571,28 @@ TEST(ArraySearchTest, NotPresent) {
   array_destroy(&a);
 }
 
+TEST(ArraySearchTest, Stressed) {
+  std::vector<int> origin;
+
+  for (int i = 0; i < 100; ++i) {
+    origin.push_back(i % 50);
+  }
+
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
+
+  for (std::size_t size = 0; size <= origin.size(); ++size) {
+    a.size = size;
+
+    for (int value = -1; value <= 50; ++value) {
+      auto expected = std::find(origin.begin(), origin.begin() + size, value) - origin.begin();
+      EXPECT_EQ(array_search(&a, value), static_cast<std::size_t>(expected));
+    }
+  }
+
+  array_destroy(&a);
+}
+
 /*
  * array_search_sorted
  */
@@ -458,1519 +648,4558 @@ TEST(ArraySearchSortedTest, NotPresentMiddle) {
   array_destroy(&a);
 }
 
-/*
- * array_is_sorted
- */
+TEST(ArraySearchSortedTest, Duplicates) {
+  static const int origin[] = { 1, 2, 2, 2, 5, 6, 6, 9 };
 
-TEST(ArrayIsSortedTest, Empty) {
   struct array a;
-  array_create(&a);
+  array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_search_sorted(&a, 2), 1u);
+  EXPECT_EQ(array_search_sorted(&a, 6), 5u);
+  EXPECT_EQ(array_search_sorted(&a, 9), 7u);
 
   array_destroy(&a);
 }
 
-TEST(ArrayIsSortedTest, Sorted) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+/*
+ * array_lower_bound
+ */
+
+TEST(ArrayLowerBoundTest, Duplicates) {
+  static const int origin[] = { 1, 2, 2, 2, 5, 6, 6, 9 };
 
   struct array a;
   array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_lower_bound(&a, 0), 0u);
+  EXPECT_EQ(array_lower_bound(&a, 1), 0u);
+  EXPECT_EQ(array_lower_bound(&a, 2), 1u);
+  EXPECT_EQ(array_lower_bound(&a, 3), 4u);
+  EXPECT_EQ(array_lower_bound(&a, 6), 5u);
+  EXPECT_EQ(array_lower_bound(&a, 9), 7u);
+  EXPECT_EQ(array_lower_bound(&a, 10), std::size(origin));
 
   array_destroy(&a);
 }
 
-TEST(ArrayIsSortedTest, NotSorted) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 10, 9, 8, 7, 6 };
-
+TEST(ArrayLowerBoundTest, Empty) {
   struct array a;
-  array_create_from(&a, origin, std::size(origin));
+  array_create(&a);
 
-  EXPECT_FALSE(array_is_sorted(&a));
+  EXPECT_EQ(array_lower_bound(&a, 0), 0u);
 
   array_destroy(&a);
 }
 
-TEST(ArrayIsSortedTest, NotSortedAtTheEnd) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0 };
+TEST(ArrayLowerBoundTest, Stressed) {
+  std::vector<int> origin;
+  std::srand(0);
+
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % BIG_SIZE);
+  }
+
+  std::sort(origin.begin(), origin.end());
 
   struct array a;
-  array_create_from(&a, origin, std::size(origin));
+  array_create_from(&a, origin.data(), origin.size());
 
-  EXPECT_FALSE(array_is_sorted(&a));
+  for (int value = -1; value <= BIG_SIZE; ++value) {
+    auto expected = std::lower_bound(origin.begin(), origin.end(), value) - origin.begin();
+    EXPECT_EQ(array_lower_bound(&a, value), static_cast<std::size_t>(expected));
+  }
 
   array_destroy(&a);
 }
 
 /*
- * array_partition
+ * array_upper_bound
  */
 
-TEST(ArrayPartitionTest, WholeSorted) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+TEST(ArrayUpperBoundTest, Duplicates) {
+  static const int origin[] = { 1, 2, 2, 2, 5, 6, 6, 9 };
 
   struct array a;
   array_create_from(&a, origin, std::size(origin));
 
-  ptrdiff_t p = array_partition(&a, 0, std::size(origin) - 1);
-  int pivot = array_get(&a, p);
+  EXPECT_EQ(array_upper_bound(&a, 0), 0u);
+  EXPECT_EQ(array_upper_bound(&a, 1), 1u);
+  EXPECT_EQ(array_upper_bound(&a, 2), 4u);
+  EXPECT_EQ(array_upper_bound(&a, 3), 4u);
+  EXPECT_EQ(array_upper_bound(&a, 6), 7u);
+  EXPECT_EQ(array_upper_bound(&a, 9), std::size(origin));
 
-  for (ptrdiff_t i = 0; i < p; ++i) {
-    EXPECT_LT(array_get(&a, i), pivot);
-  }
+  array_destroy(&a);
+}
 
-  for (ptrdiff_t i = p + 1; i < static_cast<ptrdiff_t>(std::size(origin)); ++i) {
-    EXPECT_GT(array_get(&a, i), pivot);
+TEST(ArrayUpperBoundTest, Stressed) {
+  std::vector<int> origin;
+  std::srand(0);
+
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % BIG_SIZE);
   }
 
-  for (int val : origin) {
-    EXPECT_NE(array_search(&a, val), std::size(origin));
+  std::sort(origin.begin(), origin.end());
+
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
+
+  for (int value = -1; value <= BIG_SIZE; ++value) {
+    auto expected = std::upper_bound(origin.begin(), origin.end(), value) - origin.begin();
+    EXPECT_EQ(array_upper_bound(&a, value), static_cast<std::size_t>(expected));
   }
 
   array_destroy(&a);
 }
 
-TEST(ArrayPartitionTest, WholeNotSorted) {
-  static const int origin[] = { 5, 4, 1, 6, 10, 3, 0, 9, 8, 2, 7 };
+/*
+ * array_equal_range
+ */
+
+TEST(ArrayEqualRangeTest, Present) {
+  static const int origin[] = { 1, 2, 2, 2, 5, 6, 6, 9 };
 
   struct array a;
   array_create_from(&a, origin, std::size(origin));
 
-  ptrdiff_t p = array_partition(&a, 0, std::size(origin) - 1);
-  int pivot = array_get(&a, p);
-
-  for (ptrdiff_t i = 0; i < p; ++i) {
-    EXPECT_LT(array_get(&a, i), pivot);
-  }
+  std::size_t first, last;
 
-  for (ptrdiff_t i = p + 1; i < static_cast<ptrdiff_t>(std::size(origin)); ++i) {
-    EXPECT_GT(array_get(&a, i), pivot);
-  }
+  array_equal_range(&a, 2, &first, &last);
+  EXPECT_EQ(first, 1u);
+  EXPECT_EQ(last, 4u);
 
-  for (int val : origin) {
-    EXPECT_NE(array_search(&a, val), std::size(origin));
-  }
+  array_equal_range(&a, 9, &first, &last);
+  EXPECT_EQ(first, 7u);
+  EXPECT_EQ(last, 8u);
 
   array_destroy(&a);
 }
 
-TEST(ArrayPartitionTest, PartNotSorted) {
-  static const int origin[] = { 5, 4, 1, 6, 10, 3, 0, 9, 8, 2, 7 };
+TEST(ArrayEqualRangeTest, NotPresent) {
+  static const int origin[] = { 1, 2, 2, 2, 5, 6, 6, 9 };
 
   struct array a;
   array_create_from(&a, origin, std::size(origin));
 
-  ptrdiff_t p = array_partition(&a, 3, 8);
-  int pivot = array_get(&a, p);
+  std::size_t first, last;
 
-  for (ptrdiff_t i = 3; i < p; ++i) {
-    EXPECT_LT(array_get(&a, i), pivot);
-  }
+  array_equal_range(&a, 4, &first, &last);
+  EXPECT_EQ(first, 4u);
+  EXPECT_EQ(last, 4u);
 
-  for (ptrdiff_t i = p + 1; i < 8; ++i) {
-    EXPECT_GT(array_get(&a, i), pivot);
+  array_equal_range(&a, 15, &first, &last);
+  EXPECT_EQ(first, std::size(origin));
+  EXPECT_EQ(last, std::size(origin));
+
+  array_destroy(&a);
+}
+
+/*
+ * array_lower_bound_interpolation
+ */
+
+TEST(ArrayLowerBoundInterpolationTest, Uniform) {
+  struct array a;
+  array_create(&a);
+
+  for (int i = 0; i < 100 * BIG_SIZE; ++i) {
+    array_push_back(&a, 3 * i);
   }
 
-  for (int val : origin) {
-    EXPECT_NE(array_search(&a, val), std::size(origin));
+  for (int value = -1; value < 300 * BIG_SIZE + 1; value += 7) {
+    EXPECT_EQ(array_lower_bound_interpolation(&a, value), array_lower_bound(&a, value));
   }
 
   array_destroy(&a);
 }
 
-TEST(ArrayPartitionTest, Single) {
-  static const int origin[] = { 5, 4, 1, 6, 10, 3, 0, 9, 8, 2, 7 };
+TEST(ArrayLowerBoundInterpolationTest, Skewed) {
+  std::vector<int> origin;
+  std::srand(0);
 
-  struct array a;
-  array_create_from(&a, origin, std::size(origin));
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    int value = std::rand() % BIG_SIZE;
+    origin.push_back(value * value);
+  }
 
-  ptrdiff_t p = array_partition(&a, 5, 5);
+  origin.push_back(2147483647);
+  origin.push_back(-2147483647 - 1);
+  std::sort(origin.begin(), origin.end());
 
-  EXPECT_EQ(p, 5);
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-  for (int val : origin) {
-    EXPECT_NE(array_search(&a, val), std::size(origin));
+  for (int value = -1; value <= BIG_SIZE; ++value) {
+    EXPECT_EQ(array_lower_bound_interpolation(&a, value * value), array_lower_bound(&a, value * value));
   }
 
   array_destroy(&a);
 }
 
 /*
- * array_quick_sort
+ * array_search_sorted_batch
  */
 
-TEST(ArrayQuickSortTest, NotSorted) {
-  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
+TEST(ArraySearchSortedBatchTest, Present) {
+  static const int origin[] = { 1, 2, 3, 5, 6, 7, 8, 9 };
+  static const int keys[] = { 9, 1, 5, 3, 8, 2, 7, 6 };
+  static const std::size_t expected[] = { 7, 0, 3, 2, 6, 1, 5, 4 };
 
   struct array a;
   array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_FALSE(array_is_sorted(&a));
-
-  array_quick_sort(&a);
-
-  EXPECT_TRUE(array_is_sorted(&a));
-  EXPECT_EQ(array_size(&a), std::size(origin));
+  std::size_t out[std::size(keys)];
+  array_search_sorted_batch(&a, keys, std::size(keys), out);
 
-  for (int val : origin) {
-    EXPECT_NE(array_search(&a, val), std::size(origin));
+  for (std::size_t i = 0; i < std::size(keys); ++i) {
+    EXPECT_EQ(out[i], expected[i]);
   }
 
   array_destroy(&a);
 }
 
-TEST(ArrayQuickSortTest, SortedBackward) {
-  static const int origin[] = { 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+TEST(ArraySearchSortedBatchTest, Empty) {
+  static const int keys[] = { 9, 1, 5 };
 
   struct array a;
-  array_create_from(&a, origin, std::size(origin));
-
-  EXPECT_FALSE(array_is_sorted(&a));
-
-  array_quick_sort(&a);
+  array_create(&a);
 
-  EXPECT_TRUE(array_is_sorted(&a));
-  EXPECT_EQ(array_size(&a), std::size(origin));
+  std::size_t out[std::size(keys)];
+  array_search_sorted_batch(&a, keys, std::size(keys), out);
 
-  for (int val : origin) {
-    EXPECT_NE(array_search(&a, val), std::size(origin));
+  for (std::size_t index : out) {
+    EXPECT_EQ(index, 0u);
   }
 
   array_destroy(&a);
 }
 
-TEST(ArrayQuickSortTest, Sorted) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+TEST(ArraySearchSortedBatchTest, Stressed) {
+  std::vector<int> origin;
+  std::vector<int> keys;
+  std::srand(0);
 
-  struct array a;
-  array_create_from(&a, origin, std::size(origin));
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % (20 * BIG_SIZE));
+  }
 
-  EXPECT_TRUE(array_is_sorted(&a));
+  for (int i = 0; i < BIG_SIZE + 7; ++i) {
+    keys.push_back(std::rand() % (20 * BIG_SIZE) - 5);
+  }
 
-  array_quick_sort(&a);
+  std::sort(origin.begin(), origin.end());
 
-  EXPECT_TRUE(array_is_sorted(&a));
-  EXPECT_EQ(array_size(&a), std::size(origin));
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-  for (int val : origin) {
-    EXPECT_NE(array_search(&a, val), std::size(origin));
+  std::vector<std::size_t> out(keys.size());
+  array_search_sorted_batch(&a, keys.data(), keys.size(), out.data());
+
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(out[i], array_search_sorted(&a, keys[i]));
   }
 
   array_destroy(&a);
 }
 
 /*
- * array_heap_sort
+ * array_search_sorted_batch_ordered
  */
 
-TEST(ArrayHeapSortTest, NotSorted) {
-  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
+TEST(ArraySearchSortedBatchOrderedTest, Present) {
+  static const int origin[] = { 1, 2, 2, 5, 6, 7, 8, 9 };
+  static const int keys[] = { 0, 2, 2, 4, 5, 9, 10 };
+  static const std::size_t expected[] = { 8, 1, 1, 8, 3, 7, 8 };
 
   struct array a;
   array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_FALSE(array_is_sorted(&a));
-
-  array_heap_sort(&a);
-
-  EXPECT_TRUE(array_is_sorted(&a));
-  EXPECT_EQ(array_size(&a), std::size(origin));
+  std::size_t out[std::size(keys)];
+  array_search_sorted_batch_ordered(&a, keys, std::size(keys), out);
 
-  for (int val : origin) {
-    EXPECT_NE(array_search(&a, val), std::size(origin));
+  for (std::size_t i = 0; i < std::size(keys); ++i) {
+    EXPECT_EQ(out[i], expected[i]);
   }
 
   array_destroy(&a);
 }
 
-TEST(ArrayHeapSortTest, SortedBackward) {
-  static const int origin[] = { 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
-
-  struct array a;
-  array_create_from(&a, origin, std::size(origin));
-
-  EXPECT_FALSE(array_is_sorted(&a));
-
-  array_heap_sort(&a);
-
-  EXPECT_TRUE(array_is_sorted(&a));
-  EXPECT_EQ(array_size(&a), std::size(origin));
+TEST(ArraySearchSortedBatchOrderedTest, Stressed) {
+  std::vector<int> origin;
+  std::vector<int> keys;
+  std::srand(0);
 
-  for (int val : origin) {
-    EXPECT_NE(array_search(&a, val), std::size(origin));
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % (20 * BIG_SIZE));
   }
 
-  array_destroy(&a);
-}
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    keys.push_back(std::rand() % (20 * BIG_SIZE) - 5);
+  }
 
-TEST(ArrayHeapSortTest, Sorted) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+  std::sort(origin.begin(), origin.end());
+  std::sort(keys.begin(), keys.end());
 
   struct array a;
-  array_create_from(&a, origin, std::size(origin));
-
-  EXPECT_TRUE(array_is_sorted(&a));
+  array_create_from(&a, origin.data(), origin.size());
 
-  array_heap_sort(&a);
-
-  EXPECT_TRUE(array_is_sorted(&a));
-  EXPECT_EQ(array_size(&a), std::size(origin));
+  std::vector<std::size_t> out(keys.size());
+  array_search_sorted_batch_ordered(&a, keys.data(), keys.size(), out.data());
 
-  for (int val : origin) {
-    EXPECT_NE(array_search(&a, val), std::size(origin));
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(out[i], array_search_sorted(&a, keys[i]));
   }
 
   array_destroy(&a);
 }
 
 /*
- * array_is_heap
+ * array_is_sorted
  */
 
-TEST(ArrayIsHeapTest, Empty) {
+TEST(ArrayIsSortedTest, Empty) {
   struct array a;
   array_create(&a);
 
-  EXPECT_TRUE(array_is_heap(&a));
+  EXPECT_TRUE(array_is_sorted(&a));
 
   array_destroy(&a);
 }
 
-TEST(ArrayIsHeapTest, SimpleHeap1) {
-  static const int origin[] = { 13, 6, 8, 5, 3 };
+TEST(ArrayIsSortedTest, Sorted) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 
   struct array a;
   array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_TRUE(array_is_heap(&a));
+  EXPECT_TRUE(array_is_sorted(&a));
 
   array_destroy(&a);
 }
 
-TEST(ArrayIsHeapTest, SimpleHeap2) {
-  static const int origin[] = { 81, 45, 24, 21, 6, 17, 19, 14 };
+TEST(ArrayIsSortedTest, NotSorted) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 10, 9, 8, 7, 6 };
 
   struct array a;
   array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_TRUE(array_is_heap(&a));
+  EXPECT_FALSE(array_is_sorted(&a));
 
   array_destroy(&a);
 }
 
-TEST(ArrayIsHeapTest, NotHeap1) {
-  static const int origin[] = { 6, 5, 4, 3, 1, 8 };
+TEST(ArrayIsSortedTest, NotSortedAtTheEnd) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0 };
 
   struct array a;
   array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_FALSE(array_is_heap(&a));
+  EXPECT_FALSE(array_is_sorted(&a));
 
   array_destroy(&a);
 }
 
-TEST(ArrayIsHeapTest, NotHeap2) {
-  static const int origin[] = { 6, 5, 4, 3, 1, 0, 8 };
+TEST(ArrayIsSortedTest, Stressed) {
+  std::vector<int> origin;
 
-  struct array a;
-  array_create_from(&a, origin, std::size(origin));
+  for (int i = 0; i < 100; ++i) {
+    origin.push_back(2 * i);
+  }
 
-  EXPECT_FALSE(array_is_heap(&a));
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-  array_destroy(&a);
-}
+  for (std::size_t size = 0; size <= origin.size(); ++size) {
+    a.size = size;
+    EXPECT_TRUE(array_is_sorted(&a));
 
-/*
- * array_heap_add
- */
+    for (std::size_t i = 1; i < size; ++i) {
+      int previous = a.data[i];
 
-TEST(ArrayHeapAddTest, Stressed) {
-  struct array a;
+      a.data[i] = a.data[i - 1]; // duplicates are not sorted
+      EXPECT_FALSE(array_is_sorted(&a));
 
-  array_create(&a);
+      a.data[i] = a.data[i - 1] - 1;
+      EXPECT_FALSE(array_is_sorted(&a));
 
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    array_heap_add(&a, i);
-    EXPECT_EQ(i, array_heap_top(&a));
-    EXPECT_TRUE(array_is_heap(&a));
+      a.data[i] = previous;
+    }
   }
 
   array_destroy(&a);
 }
 
 /*
- * array_heap_remove_top
+ * array_partition
  */
 
-TEST(ArrayHeapRemoveTopTest, Stressed) {
+TEST(ArrayPartitionTest, WholeSorted) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+
   struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  array_create(&a);
+  ptrdiff_t p = array_partition(&a, 0, std::size(origin) - 1);
+  int pivot = array_get(&a, p);
 
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    array_heap_add(&a, i);
+  for (ptrdiff_t i = 0; i < p; ++i) {
+    EXPECT_LT(array_get(&a, i), pivot);
   }
 
-  EXPECT_TRUE(array_is_heap(&a));
-
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    EXPECT_EQ(BIG_SIZE - i - 1, array_heap_top(&a));
-    array_heap_remove_top(&a);
+  for (ptrdiff_t i = p + 1; i < static_cast<ptrdiff_t>(std::size(origin)); ++i) {
+    EXPECT_GT(array_get(&a, i), pivot);
   }
 
-  EXPECT_TRUE(array_empty(&a));
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
+  }
 
   array_destroy(&a);
 }
 
+TEST(ArrayPartitionTest, WholeNotSorted) {
+  static const int origin[] = { 5, 4, 1, 6, 10, 3, 0, 9, 8, 2, 7 };
 
-/*
- * list_create
- */
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-TEST(ListCreateTest, Empty) {
-  struct list l;
+  ptrdiff_t p = array_partition(&a, 0, std::size(origin) - 1);
+  int pivot = array_get(&a, p);
 
-  list_create(&l);
+  for (ptrdiff_t i = 0; i < p; ++i) {
+    EXPECT_LT(array_get(&a, i), pivot);
+  }
 
-  EXPECT_TRUE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), 0u);
-  EXPECT_EQ(l.first, nullptr);
-  EXPECT_EQ(l.last, nullptr);
+  for (ptrdiff_t i = p + 1; i < static_cast<ptrdiff_t>(std::size(origin)); ++i) {
+    EXPECT_GT(array_get(&a, i), pivot);
+  }
 
-  list_destroy(&l);
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
+  }
+
+  array_destroy(&a);
 }
 
-/*
- * list_create_from
- */
+TEST(ArrayPartitionTest, PartNotSorted) {
+  static const int origin[] = { 5, 4, 1, 6, 10, 3, 0, 9, 8, 2, 7 };
 
-TEST(ListCreateFromTest, OneElement) {
-  static const int origin[] = { 1 };
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  ptrdiff_t p = array_partition(&a, 3, 8);
+  int pivot = array_get(&a, p);
 
-  EXPECT_FALSE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), std::size(origin));
-  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
-  EXPECT_EQ(l.first, l.last);
+  for (ptrdiff_t i = 3; i < p; ++i) {
+    EXPECT_LT(array_get(&a, i), pivot);
+  }
 
+  for (ptrdiff_t i = p + 1; i < 8; ++i) {
+    EXPECT_GT(array_get(&a, i), pivot);
+  }
 
-  list_destroy(&l);
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
+  }
+
+  array_destroy(&a);
 }
 
-TEST(ListCreateFromTest, ManyElements) {
-  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+TEST(ArrayPartitionTest, Single) {
+  static const int origin[] = { 5, 4, 1, 6, 10, 3, 0, 9, 8, 2, 7 };
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_FALSE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), std::size(origin));
-  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
+  ptrdiff_t p = array_partition(&a, 5, 5);
 
+  EXPECT_EQ(p, 5);
 
-  list_destroy(&l);
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
+  }
+
+  array_destroy(&a);
 }
 
 /*
- * list_equals
+ * array_quick_sort
  */
 
-TEST(ListEqualsTest, DifferentElement) {
-  static const int origin[]    = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
-  static const int reference[] = { 1, 2, 3, 4, 5, 6, 7, 8, 10 };
-
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+TEST(ArrayQuickSortTest, NotSorted) {
+  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
 
-  EXPECT_FALSE(list_equals(&l, reference, std::size(reference)));
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  list_destroy(&l);
-}
+  EXPECT_FALSE(array_is_sorted(&a));
 
-TEST(ListEqualsTest, SizeShorter) {
-  static const int origin[]    = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
-  static const int reference[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  array_quick_sort(&a);
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_size(&a), std::size(origin));
 
-  EXPECT_FALSE(list_equals(&l, reference, std::size(reference)));
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
+  }
 
-  list_destroy(&l);
+  array_destroy(&a);
 }
 
-TEST(ListEqualsTest, SizeLarger) {
-  static const int origin[]    = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
-  static const int reference[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
-
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+TEST(ArrayQuickSortTest, SortedBackward) {
+  static const int origin[] = { 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
 
-  EXPECT_FALSE(list_equals(&l, reference, std::size(reference)));
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  list_destroy(&l);
-}
+  EXPECT_FALSE(array_is_sorted(&a));
 
-/*
- * list_push_front
- */
+  array_quick_sort(&a);
 
-TEST(ListPushFrontTest, OneElement) {
-  struct list l;
-  list_create(&l);
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_size(&a), std::size(origin));
 
-  list_push_front(&l, 1);
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
+  }
 
-  EXPECT_FALSE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), 1u);
-  EXPECT_EQ(list_get(&l, 0), 1);
-  EXPECT_EQ(l.first, l.last);
+  array_destroy(&a);
+}
 
+TEST(ArrayQuickSortTest, Sorted) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 
-  list_destroy(&l);
-}
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
+  EXPECT_TRUE(array_is_sorted(&a));
 
-TEST(ListPushFrontTest, ManyElements) {
-  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
+  array_quick_sort(&a);
 
-  struct list l;
-  list_create(&l);
-
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    list_push_front(&l, origin[std::size(origin) - i - 1]);
-  }
-
-  EXPECT_FALSE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), std::size(origin));
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_size(&a), std::size(origin));
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    EXPECT_EQ(list_get(&l, i), origin[i]);
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
   }
 
-  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
-
-  list_destroy(&l);
+  array_destroy(&a);
 }
 
+TEST(ArrayQuickSortTest, Stressed) {
+  std::vector<int> origin;
+  std::srand(0);
 
-TEST(ListPushFrontTest, Stressed) {
-  struct list l;
-  list_create(&l);
-
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    list_push_front(&l, i + 1);
-    EXPECT_EQ(list_get(&l, 0), i + 1);
-    EXPECT_EQ(list_size(&l), static_cast<std::size_t>(i + 1));
+  for (int i = 0; i < 100 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % BIG_SIZE);
   }
 
-  EXPECT_FALSE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), static_cast<std::size_t>(BIG_SIZE));
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    EXPECT_EQ(list_get(&l, BIG_SIZE - i - 1), i + 1);
-  }
+  array_quick_sort(&a);
 
-  list_destroy(&l);
+  std::sort(origin.begin(), origin.end());
+  EXPECT_TRUE(array_equals(&a, origin.data(), origin.size()));
+
+  array_destroy(&a);
 }
 
-/*
- * list_pop_front
- */
+TEST(ArrayQuickSortTest, AllEqual) {
+  std::vector<int> origin(100 * BIG_SIZE, 42);
 
-TEST(ListPopFrontTest, OneElement) {
-  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  array_quick_sort(&a);
 
-  EXPECT_EQ(list_size(&l), std::size(origin));
+  EXPECT_TRUE(array_equals(&a, origin.data(), origin.size()));
 
-  list_pop_front(&l);
+  array_destroy(&a);
+}
 
-  EXPECT_EQ(list_size(&l), std::size(origin) - 1);
+TEST(ArrayQuickSortTest, SortedStressed) {
+  std::vector<int> origin;
 
-  for (std::size_t i = 0; i < std::size(origin) - 1; ++i) {
-    EXPECT_EQ(list_get(&l, i), origin[i + 1]);
+  for (int i = 0; i < 500 * BIG_SIZE; ++i) {
+    origin.push_back(i);
   }
 
-  list_destroy(&l);
-}
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-TEST(ListPopFrontTest, ManyElements) {
-  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  array_quick_sort(&a);
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_TRUE(array_equals(&a, origin.data(), origin.size()));
 
-  EXPECT_EQ(list_size(&l), std::size(origin));
+  array_destroy(&a);
+}
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    list_pop_front(&l);
+TEST(ArrayQuickSortTest, OrganPipe) {
+  std::vector<int> origin;
+
+  for (int i = 0; i < 50 * BIG_SIZE; ++i) {
+    origin.push_back(i);
   }
 
-  EXPECT_TRUE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), 0u);
+  for (int i = 50 * BIG_SIZE; i > 0; --i) {
+    origin.push_back(i);
+  }
 
-  list_destroy(&l);
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
+
+  array_quick_sort(&a);
+
+  std::sort(origin.begin(), origin.end());
+  EXPECT_TRUE(array_equals(&a, origin.data(), origin.size()));
+
+  array_destroy(&a);
 }
 
 /*
- * list_push_back
+ * array_radix_sort
  */
 
-TEST(ListPushBackTest, OneElement) {
-  struct list l;
-  list_create(&l);
+TEST(ArrayRadixSortTest, NotSorted) {
+  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
 
-  list_push_back(&l, 1);
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_FALSE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), 1u);
-  EXPECT_EQ(list_get(&l, 0), 1);
-  EXPECT_EQ(l.first, l.last);
+  EXPECT_FALSE(array_is_sorted(&a));
 
+  array_radix_sort(&a);
 
-  list_destroy(&l);
-}
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_size(&a), std::size(origin));
 
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
+  }
 
-TEST(ListPushBackTest, ManyElements) {
-  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
+  array_destroy(&a);
+}
 
-  struct list l;
-  list_create(&l);
+TEST(ArrayRadixSortTest, Negative) {
+  std::vector<int> origin;
+  std::srand(0);
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    list_push_back(&l, origin[i]);
+  for (int i = 0; i < 100 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() - RAND_MAX / 2);
   }
 
-  EXPECT_FALSE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), std::size(origin));
+  origin.push_back(2147483647);
+  origin.push_back(-2147483647 - 1);
+  origin.push_back(0);
+  origin.push_back(-1);
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    EXPECT_EQ(list_get(&l, i), origin[i]);
-  }
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
+  array_radix_sort(&a);
 
-  list_destroy(&l);
-}
+  std::sort(origin.begin(), origin.end());
+  EXPECT_TRUE(array_equals(&a, origin.data(), origin.size()));
 
+  array_destroy(&a);
+}
 
-TEST(ListPushBackTest, Stressed) {
-  struct list l;
-  list_create(&l);
+TEST(ArrayRadixSortTest, SmallKeys) {
+  std::vector<int> origin;
+  std::srand(0);
 
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    list_push_back(&l, i + 1);
-    EXPECT_EQ(list_get(&l, i), i + 1);
-    EXPECT_EQ(list_size(&l), static_cast<std::size_t>(i + 1));
+  for (int i = 0; i < 100 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % 100);
   }
 
-  EXPECT_FALSE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), static_cast<std::size_t>(BIG_SIZE));
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    EXPECT_EQ(list_get(&l, i), i + 1);
-  }
+  array_radix_sort(&a);
 
-  list_destroy(&l);
-}
+  std::sort(origin.begin(), origin.end());
+  EXPECT_TRUE(array_equals(&a, origin.data(), origin.size()));
 
-/*
- * list_pop_back
- */
+  array_push_back(&a, 100);
+  EXPECT_EQ(array_get(&a, origin.size()), 100);
 
-TEST(ListPopBackTest, OneElement) {
-  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  array_destroy(&a);
+}
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+TEST(ArrayRadixSortTest, KeepsCapacity) {
+  std::vector<int> origin;
+  std::srand(0);
 
-  EXPECT_EQ(list_size(&l), std::size(origin));
+  for (int i = 0; i < 100 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % 100); // a single pass, the result ends in the scratch buffer
+  }
 
-  list_pop_back(&l);
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
+  array_reserve(&a, 2 * origin.size());
+  std::size_t capacity = a.capacity;
 
-  EXPECT_EQ(list_size(&l), std::size(origin) - 1);
+  array_radix_sort(&a);
 
-  for (std::size_t i = 0; i < std::size(origin) - 1; ++i) {
-    EXPECT_EQ(list_get(&l, i), origin[i]);
-  }
+  std::sort(origin.begin(), origin.end());
+  EXPECT_TRUE(array_equals(&a, origin.data(), origin.size()));
+  EXPECT_EQ(a.capacity, capacity);
 
-  list_destroy(&l);
+  const int *data = a.data;
+  array_push_back(&a, 100);
+  EXPECT_EQ(a.data, data);
+
+  array_destroy(&a);
 }
 
-TEST(ListPopBackTest, ManyElements) {
-  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+/*
+ * array_parallel_sort
+ */
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+TEST(ArrayParallelSortTest, NotSorted) {
+  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
 
-  EXPECT_EQ(list_size(&l), std::size(origin));
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    list_pop_back(&l);
-  }
+  array_parallel_sort(&a, 4);
 
-  EXPECT_TRUE(list_empty(&l));
-  EXPECT_EQ(list_size(&l), 0u);
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_size(&a), std::size(origin));
 
-  list_destroy(&l);
+  array_destroy(&a);
 }
 
-/*
- * list_insert
- */
+TEST(ArrayParallelSortTest, Stressed) {
+  std::vector<int> origin;
+  std::srand(0);
 
-TEST(ListInsertTest, Beginning) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
-  static const int expected[] = { 42, 9, 3, 7, 2, 4, 0, 8 };
+  for (int i = 0; i < 1000 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % (100 * BIG_SIZE));
+  }
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  for (unsigned threads : { 0u, 2u, 3u, 8u }) {
+    struct array a;
+    array_create_from(&a, origin.data(), origin.size());
 
-  list_insert(&l, 42, 0); // insert at the beginning
+    array_parallel_sort(&a, threads);
 
-  EXPECT_EQ(list_size(&l), std::size(expected));
-  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+    std::vector<int> expected(origin);
+    std::sort(expected.begin(), expected.end());
+    EXPECT_TRUE(array_equals(&a, expected.data(), expected.size()));
 
-  list_destroy(&l);
+    array_destroy(&a);
+  }
 }
 
-TEST(ListInsertTest, Middle) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
-  static const int expected[] = { 9, 3, 7, 42, 2, 4, 0, 8 };
+TEST(ArrayParallelSortTest, SortedBackward) {
+  std::vector<int> origin;
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  for (int i = 500 * BIG_SIZE; i > 0; --i) {
+    origin.push_back(i);
+  }
 
-  list_insert(&l, 42, 3); // insert in the middle
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-  EXPECT_EQ(list_size(&l), std::size(expected));
-  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+  array_parallel_sort(&a, 4);
 
-  list_destroy(&l);
-}
+  std::sort(origin.begin(), origin.end());
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_TRUE(array_equals(&a, origin.data(), origin.size()));
 
-TEST(ListInsertTest, End) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
-  static const int expected[] = { 9, 3, 7, 2, 4, 0, 8, 42 };
+  array_destroy(&a);
+}
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+/*
+ * array_heap_sort
+ */
 
-  list_insert(&l, 42, std::size(origin)); // insert at the end
+TEST(ArrayHeapSortTest, NotSorted) {
+  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
 
-  EXPECT_EQ(list_size(&l), std::size(expected));
-  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  list_destroy(&l);
-}
+  EXPECT_FALSE(array_is_sorted(&a));
 
-TEST(ListInsertTest, Stressed) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+  array_heap_sort(&a);
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_size(&a), std::size(origin));
 
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    list_insert(&l, i + 1, 4);
-    EXPECT_EQ(list_size(&l), std::size(origin) + i + 1);
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
   }
 
-  list_destroy(&l);
+  array_destroy(&a);
 }
 
-/*
- * list_remove
- */
+TEST(ArrayHeapSortTest, SortedBackward) {
+  static const int origin[] = { 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
 
-TEST(ListRemoveTest, Beginning) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
-  static const int expected[] = { 3, 7, 2, 4, 0, 8 };
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  EXPECT_FALSE(array_is_sorted(&a));
 
-  list_remove(&l, 0); // remove at the beginning
+  array_heap_sort(&a);
 
-  EXPECT_EQ(list_size(&l), std::size(expected));
-  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_size(&a), std::size(origin));
 
-  list_destroy(&l);
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
+  }
+
+  array_destroy(&a);
 }
 
-TEST(ListRemoveTest, Middle) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
-  static const int expected[] = { 9, 3, 7, 4, 0, 8 };
+TEST(ArrayHeapSortTest, Sorted) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  list_remove(&l, 3); // remove in the middle
+  EXPECT_TRUE(array_is_sorted(&a));
 
-  EXPECT_EQ(list_size(&l), std::size(expected));
-  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+  array_heap_sort(&a);
 
-  list_destroy(&l);
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_size(&a), std::size(origin));
+
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
+  }
+
+  array_destroy(&a);
 }
 
-TEST(ListRemoveTest, End) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
-  static const int expected[] = { 9, 3, 7, 2, 4, 0 };
+TEST(ArrayHeapSortTest, Stressed) {
+  std::vector<int> origin;
+  std::srand(0);
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  for (int i = 0; i < 100 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % BIG_SIZE);
+  }
 
-  list_remove(&l, std::size(origin) - 1); // remove at the end
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-  EXPECT_EQ(list_size(&l), std::size(expected));
-  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+  array_heap_sort(&a);
 
-  list_destroy(&l);
+  std::sort(origin.begin(), origin.end());
+  EXPECT_TRUE(array_equals(&a, origin.data(), origin.size()));
+
+  array_destroy(&a);
 }
 
 /*
- * list_get
+ * array_heap_sort_bottom_up
  */
 
-TEST(ListGetTest, ValidIndex) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+TEST(ArrayHeapSortBottomUpTest, NotSorted) {
+  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    EXPECT_EQ(list_get(&l, i), origin[i]);
+  EXPECT_FALSE(array_is_sorted(&a));
+
+  array_heap_sort_bottom_up(&a);
+
+  EXPECT_TRUE(array_is_sorted(&a));
+  EXPECT_EQ(array_size(&a), std::size(origin));
+
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
   }
 
-  list_destroy(&l);
+  array_destroy(&a);
 }
 
-TEST(ListGetTest, NotValidIndex) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+TEST(ArrayHeapSortBottomUpTest, Stressed) {
+  std::vector<int> origin;
+  std::srand(0);
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  for (int i = 0; i < 100 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % BIG_SIZE);
+  }
 
-  EXPECT_EQ(list_get(&l, std::size(origin)), 0);
-  EXPECT_EQ(list_get(&l, -1), 0);
+  struct array a;
+  array_create_from(&a, origin.data(), origin.size());
 
-  list_destroy(&l);
+  array_heap_sort_bottom_up(&a);
+
+  std::sort(origin.begin(), origin.end());
+  EXPECT_TRUE(array_equals(&a, origin.data(), origin.size()));
+
+  array_destroy(&a);
 }
 
 /*
- * list_set
+ * array_heapify
  */
 
-TEST(ListSetTest, ValidIndex) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+TEST(ArrayHeapifyTest, NotHeap) {
+  static const int origin[] = { 6, 5, 4, 3, 1, 0, 8 };
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    list_set(&l, i, origin[i] - 1);
-    EXPECT_EQ(list_get(&l, i), origin[i] - 1);
-  }
+  EXPECT_FALSE(array_is_heap(&a));
 
-  EXPECT_EQ(list_size(&l), std::size(origin));
+  array_heapify(&a);
 
-  list_destroy(&l);
+  EXPECT_TRUE(array_is_heap(&a));
+  EXPECT_EQ(array_heap_top(&a), 8);
+  EXPECT_EQ(array_size(&a), std::size(origin));
+
+  for (int val : origin) {
+    EXPECT_NE(array_search(&a, val), std::size(origin));
+  }
+
+  array_destroy(&a);
 }
 
-TEST(ListSetTest, NotValidIndex) {
-  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+TEST(ArrayHeapifyTest, Stressed) {
+  struct array a;
+  array_create(&a);
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  std::srand(0);
 
-  list_set(&l, std::size(origin), 42);
-  list_set(&l, -1, 42);
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    array_push_back(&a, std::rand() % 100);
+  }
 
-  EXPECT_EQ(list_size(&l), std::size(origin));
+  array_heapify(&a);
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    EXPECT_EQ(list_get(&l, i), origin[i]);
+  EXPECT_TRUE(array_is_heap(&a));
+
+  int previous = array_heap_top(&a);
+
+  while (!array_empty(&a)) {
+    EXPECT_LE(array_heap_top(&a), previous);
+    previous = array_heap_top(&a);
+    array_heap_remove_top(&a);
   }
 
-  list_destroy(&l);
+  array_destroy(&a);
 }
 
 /*
- * list_search
+ * array_is_heap
  */
 
-TEST(ListSearchTest, Present) {
-  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+TEST(ArrayIsHeapTest, Empty) {
+  struct array a;
+  array_create(&a);
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  EXPECT_TRUE(array_is_heap(&a));
 
-  for (size_t i = 0; i < std::size(origin); ++i) {
-    size_t index = list_search(&l, origin[i]);
-    EXPECT_EQ(index, i);
-  }
+  array_destroy(&a);
+}
 
-  list_destroy(&l);
+TEST(ArrayIsHeapTest, SimpleHeap1) {
+  static const int origin[] = { 13, 6, 8, 5, 3 };
+
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
+
+  EXPECT_TRUE(array_is_heap(&a));
+
+  array_destroy(&a);
 }
 
-TEST(ListSearchTest, NotPresent) {
-  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+TEST(ArrayIsHeapTest, SimpleHeap2) {
+  static const int origin[] = { 81, 45, 24, 21, 6, 17, 19, 14 };
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  size_t index = list_search(&l, -1);
-  EXPECT_EQ(index, std::size(origin));
+  EXPECT_TRUE(array_is_heap(&a));
 
-  list_destroy(&l);
+  array_destroy(&a);
 }
 
-/*
- * list_is_sorted
- */
+TEST(ArrayIsHeapTest, NotHeap1) {
+  static const int origin[] = { 6, 5, 4, 3, 1, 8 };
 
-TEST(ListIsSortedTest, Empty) {
-  struct list l;
-  list_create(&l);
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_TRUE(list_is_sorted(&l));
+  EXPECT_FALSE(array_is_heap(&a));
 
-  list_destroy(&l);
+  array_destroy(&a);
 }
 
-TEST(ListIsSortedTest, Sorted) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+TEST(ArrayIsHeapTest, NotHeap2) {
+  static const int origin[] = { 6, 5, 4, 3, 1, 0, 8 };
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
 
-  EXPECT_TRUE(list_is_sorted(&l));
+  EXPECT_FALSE(array_is_heap(&a));
 
-  list_destroy(&l);
+  array_destroy(&a);
 }
 
-TEST(ListIsSortedTest, NotSorted) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 10, 9, 8, 7, 6 };
+/*
+ * array_heap_add
+ */
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+TEST(ArrayHeapAddTest, Stressed) {
+  struct array a;
 
-  EXPECT_FALSE(list_is_sorted(&l));
+  array_create(&a);
 
-  list_destroy(&l);
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    array_heap_add(&a, i);
+    EXPECT_EQ(i, array_heap_top(&a));
+    EXPECT_TRUE(array_is_heap(&a));
+  }
+
+  array_destroy(&a);
 }
 
-TEST(ListIsSortedTest, NotSortedAtTheEnd) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0 };
+/*
+ * array_heap_remove_top
+ */
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+TEST(ArrayHeapRemoveTopTest, Stressed) {
+  struct array a;
 
-  EXPECT_FALSE(list_is_sorted(&l));
+  array_create(&a);
 
-  list_destroy(&l);
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    array_heap_add(&a, i);
+  }
+
+  EXPECT_TRUE(array_is_heap(&a));
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    EXPECT_EQ(BIG_SIZE - i - 1, array_heap_top(&a));
+    array_heap_remove_top(&a);
+  }
+
+  EXPECT_TRUE(array_empty(&a));
+
+  array_destroy(&a);
 }
 
+
 /*
- * list_split
+ * array_index_search
  */
 
-TEST(ListSplitTest, EvenSize) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
-  assert(std::size(origin) % 2 == 0);
+TEST(ArrayIndexSearchTest, Present) {
+  static const int origin[] = { 1, 2, 3, 5, 6, 7, 8, 9 };
+
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
+
+  struct array_index index;
+  array_index_build(&index, &a);
+
+  for (size_t i = 0; i < std::size(origin); ++i) {
+    EXPECT_EQ(array_index_search(&index, origin[i]), i);
+  }
+
+  array_index_destroy(&index);
+  array_destroy(&a);
+}
+
+TEST(ArrayIndexSearchTest, NotPresent) {
+  static const int origin[] = { 1, 2, 3, 5, 6, 7, 8, 9 };
+
+  struct array a;
+  array_create_from(&a, origin, std::size(origin));
+
+  struct array_index index;
+  array_index_build(&index, &a);
+
+  EXPECT_EQ(array_index_search(&index, -1), std::size(origin)); // before everything
+  EXPECT_EQ(array_index_search(&index, 4), std::size(origin));  // in the middle of other elements
+  EXPECT_EQ(array_index_search(&index, 15), std::size(origin)); // after everything
+
+  array_index_destroy(&index);
+  array_destroy(&a);
+}
+
+TEST(ArrayIndexSearchTest, Empty) {
+  struct array a;
+  array_create(&a);
+
+  struct array_index index;
+  array_index_build(&index, &a);
+
+  EXPECT_EQ(array_index_search(&index, 0), 0u);
+
+  array_index_destroy(&index);
+  array_destroy(&a);
+}
+
+TEST(ArrayIndexSearchTest, Stressed) {
+  std::vector<int> origin;
+  std::srand(0);
+
+  for (int size = 1; size < BIG_SIZE; size += 37) {
+    origin.clear();
+
+    for (int i = 0; i < size; ++i) {
+      origin.push_back(std::rand() % (2 * size));
+    }
+
+    std::sort(origin.begin(), origin.end());
+
+    struct array a;
+    array_create_from(&a, origin.data(), origin.size());
+
+    struct array_index index;
+    array_index_build(&index, &a);
+
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(index.data) % 64, 0u);
+
+    for (int value = -1; value <= 2 * size; ++value) {
+      EXPECT_EQ(array_index_search(&index, value), array_search_sorted(&a, value));
+    }
+
+    array_index_destroy(&index);
+    array_destroy(&a);
+  }
+}
+
+
+/*
+ * pqueue_create
+ */
+
+TEST(PqueueCreateTest, Empty) {
+  struct pqueue q;
+  pqueue_create(&q, false);
+
+  EXPECT_TRUE(pqueue_empty(&q));
+  EXPECT_EQ(pqueue_size(&q), 0u);
+
+  pqueue_destroy(&q);
+}
+
+/*
+ * pqueue_create_from
+ */
+
+TEST(PqueueCreateFromTest, Max) {
+  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
+
+  struct pqueue q;
+  pqueue_create_from(&q, origin, std::size(origin), false);
+
+  EXPECT_EQ(pqueue_size(&q), std::size(origin));
+
+  for (int i = 10; i >= 0; --i) {
+    EXPECT_EQ(pqueue_top(&q), i);
+    pqueue_pop(&q);
+  }
+
+  EXPECT_TRUE(pqueue_empty(&q));
+
+  pqueue_destroy(&q);
+}
+
+TEST(PqueueCreateFromTest, Min) {
+  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
+
+  struct pqueue q;
+  pqueue_create_from(&q, origin, std::size(origin), true);
+
+  for (int i = 0; i <= 10; ++i) {
+    EXPECT_EQ(pqueue_top(&q), i);
+    pqueue_pop(&q);
+  }
+
+  EXPECT_TRUE(pqueue_empty(&q));
+
+  pqueue_destroy(&q);
+}
+
+/*
+ * pqueue_push
+ */
+
+TEST(PqueuePushTest, Stressed) {
+  std::vector<int> origin;
+  std::srand(0);
+
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % BIG_SIZE - BIG_SIZE / 2);
+  }
+
+  origin.push_back(2147483647);
+  origin.push_back(-2147483647 - 1);
+
+  for (bool min : { false, true }) {
+    struct pqueue q;
+    pqueue_create(&q, min);
+
+    for (int val : origin) {
+      pqueue_push(&q, val);
+    }
+
+    EXPECT_EQ(pqueue_size(&q), origin.size());
+
+    std::vector<int> expected(origin);
+    std::sort(expected.begin(), expected.end());
+
+    if (!min) {
+      std::reverse(expected.begin(), expected.end());
+    }
+
+    for (int val : expected) {
+      EXPECT_EQ(pqueue_top(&q), val);
+      pqueue_pop(&q);
+    }
+
+    EXPECT_TRUE(pqueue_empty(&q));
+
+    pqueue_destroy(&q);
+  }
+}
+
+/*
+ * pqueue_push_pop
+ */
+
+TEST(PqueuePushPopTest, Max) {
+  static const int origin[] = { 8, 4, 1, 6 };
+
+  struct pqueue q;
+  pqueue_create_from(&q, origin, std::size(origin), false);
+
+  EXPECT_EQ(pqueue_push_pop(&q, 10), 10); // greater than the top
+  EXPECT_EQ(pqueue_size(&q), std::size(origin));
+  EXPECT_EQ(pqueue_top(&q), 8);
+
+  EXPECT_EQ(pqueue_push_pop(&q, 5), 8);
+  EXPECT_EQ(pqueue_size(&q), std::size(origin));
+  EXPECT_EQ(pqueue_top(&q), 6);
+
+  pqueue_destroy(&q);
+}
+
+TEST(PqueuePushPopTest, Empty) {
+  struct pqueue q;
+  pqueue_create(&q, true);
+
+  EXPECT_EQ(pqueue_push_pop(&q, 42), 42);
+  EXPECT_TRUE(pqueue_empty(&q));
+
+  pqueue_destroy(&q);
+}
+
+/*
+ * pqueue_replace_top
+ */
+
+TEST(PqueueReplaceTopTest, Min) {
+  static const int origin[] = { 8, 4, 1, 6 };
+
+  struct pqueue q;
+  pqueue_create_from(&q, origin, std::size(origin), true);
+
+  EXPECT_EQ(pqueue_replace_top(&q, 0), 1); // smaller than the top
+  EXPECT_EQ(pqueue_top(&q), 0);
+
+  EXPECT_EQ(pqueue_replace_top(&q, 10), 0);
+  EXPECT_EQ(pqueue_top(&q), 4);
+  EXPECT_EQ(pqueue_size(&q), std::size(origin));
+
+  pqueue_destroy(&q);
+}
+
+TEST(PqueueReplaceTopTest, Stressed) {
+  struct pqueue q;
+  pqueue_create(&q, true);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    pqueue_push(&q, i);
+  }
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    EXPECT_EQ(pqueue_replace_top(&q, BIG_SIZE + i), i);
+  }
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    EXPECT_EQ(pqueue_top(&q), BIG_SIZE + i);
+    pqueue_pop(&q);
+  }
+
+  pqueue_destroy(&q);
+}
+
+
+/*
+ * node_pool
+ */
+
+TEST(NodePoolTest, Reuse) {
+  struct node_pool pool;
+  node_pool_create(&pool, sizeof(struct list_node), false);
+
+  void *first = node_pool_alloc(&pool);
+  void *second = node_pool_alloc(&pool);
+
+  EXPECT_NE(first, second);
+  EXPECT_EQ(pool.live, 2u);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) % alignof(void *), 0u);
+
+  node_pool_free(&pool, first);
+  EXPECT_EQ(pool.live, 1u);
+  EXPECT_EQ(node_pool_alloc(&pool), first);
+
+  node_pool_destroy(&pool);
+}
+
+TEST(NodePoolTest, ManySlabs) {
+  struct node_pool pool;
+  node_pool_create(&pool, sizeof(struct tree_node), false);
+
+  std::vector<struct tree_node *> nodes;
+
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    struct tree_node *node = static_cast<struct tree_node *>(node_pool_alloc(&pool));
+    node->data = i;
+    nodes.push_back(node);
+  }
+
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    EXPECT_EQ(nodes[i]->data, i);
+  }
+
+  EXPECT_EQ(pool.live, nodes.size());
+
+  node_pool_release(&pool);
+  EXPECT_EQ(pool.live, 0u);
+  EXPECT_EQ(pool.slabs, nullptr);
+
+  void *node = node_pool_alloc(&pool); // still usable after a release
+  EXPECT_NE(node, nullptr);
+
+  node_pool_destroy(&pool);
+}
+
+TEST(NodePoolTest, SharedThreads) {
+  struct node_pool pool;
+  node_pool_create(&pool, sizeof(struct list_node), true);
+
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool, t]() {
+      struct list l;
+      list_create_with_pool(&l, &pool);
+
+      for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < BIG_SIZE; ++i) {
+          list_push_back(&l, t * BIG_SIZE + i);
+        }
+
+        for (int i = 0; i < BIG_SIZE; ++i) {
+          EXPECT_EQ(l.first->data, t * BIG_SIZE + i);
+          list_pop_front(&l);
+        }
+      }
+
+      list_destroy(&l);
+    });
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  node_pool_destroy(&pool);
+}
+
+TEST(NodePoolTest, SharedAlternate) {
+  struct node_pool pools[2 * 4];
+  struct list lists[2 * 4];
+
+  for (int i = 0; i < 2 * 4; ++i) {
+    node_pool_create(&pools[i], sizeof(struct list_node), true);
+    list_create_with_pool(&lists[i], &pools[i]);
+  }
+
+  for (int round = 0; round < 100 * BIG_SIZE; ++round) {
+    struct list *l = &lists[round % (2 * 4)];
+    list_push_back(l, round);
+    list_pop_front(l);
+  }
+
+  for (int i = 0; i < 2 * 4; ++i) {
+    EXPECT_TRUE(list_empty(&lists[i]));
+    EXPECT_LE(pools[i].live, 64u); // au plus le cache du thread
+    list_destroy(&lists[i]);
+    node_pool_destroy(&pools[i]);
+  }
+}
+
+TEST(NodePoolTest, ListBulkRelease) {
+  struct node_pool pool;
+  node_pool_create(&pool, sizeof(struct list_node), false);
+
+  struct list l;
+  list_create_with_pool(&l, &pool);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    list_push_back(&l, i);
+  }
+
+  for (int i = 0; i < BIG_SIZE; i += 2) {
+    list_remove(&l, list_search(&l, i));
+  }
+
+  list_insert(&l, -1, 0);
+
+  EXPECT_EQ(pool.live, list_size(&l));
+
+  struct list other;
+  list_create_with_pool(&other, &pool);
+  list_push_back(&other, 42);
+
+  list_destroy(&l); // other still uses the pool: the nodes are freed one by one
+
+  EXPECT_TRUE(list_empty(&l));
+  EXPECT_EQ(pool.live, 1u);
+
+  list_destroy(&other); // last user: the slabs are freed at once
+
+  EXPECT_EQ(pool.live, 0u);
+  EXPECT_EQ(pool.slabs, nullptr);
+
+  list_push_back(&other, 1); // the list stays attached to its pool
+
+  EXPECT_EQ(pool.live, 1u);
+
+  list_destroy(&other);
+  node_pool_destroy(&pool);
+}
+
+TEST(NodePoolTest, ListMergeSort) {
+  struct node_pool pool;
+  node_pool_create(&pool, sizeof(struct list_node), false);
+
+  struct list l;
+  list_create_with_pool(&l, &pool);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    list_push_front(&l, (i * 7919) % BIG_SIZE);
+  }
+
+  list_merge_sort(&l);
+
+  EXPECT_TRUE(list_is_sorted(&l));
+  EXPECT_EQ(l.pool, &pool);
+
+  list_destroy(&l);
+  node_pool_destroy(&pool);
+}
+
+/*
+ * list_create
+ */
+
+TEST(ListCreateTest, Empty) {
+  struct list l;
+
+  list_create(&l);
+
+  EXPECT_TRUE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), 0u);
+  EXPECT_EQ(l.first, nullptr);
+  EXPECT_EQ(l.last, nullptr);
+
+  list_destroy(&l);
+}
+
+/*
+ * list_create_from
+ */
+
+TEST(ListCreateFromTest, OneElement) {
+  static const int origin[] = { 1 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_FALSE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), std::size(origin));
+  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
+  EXPECT_EQ(l.first, l.last);
+
+
+  list_destroy(&l);
+}
+
+TEST(ListCreateFromTest, ManyElements) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_FALSE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), std::size(origin));
+  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
+
+
+  list_destroy(&l);
+}
+
+/*
+ * list_destroy
+ */
+
+TEST(ListDestroyTest, Stressed) {
+  struct list l;
+  list_create(&l);
+
+  for (int i = 0; i < 1000 * BIG_SIZE; ++i) {
+    list_push_front(&l, i);
+  }
+
+  list_destroy(&l);
+
+  EXPECT_TRUE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), 0u);
+}
+
+/*
+ * list_equals
+ */
+
+TEST(ListEqualsTest, DifferentElement) {
+  static const int origin[]    = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  static const int reference[] = { 1, 2, 3, 4, 5, 6, 7, 8, 10 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_FALSE(list_equals(&l, reference, std::size(reference)));
+
+  list_destroy(&l);
+}
+
+TEST(ListEqualsTest, SizeShorter) {
+  static const int origin[]    = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  static const int reference[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_FALSE(list_equals(&l, reference, std::size(reference)));
+
+  list_destroy(&l);
+}
+
+TEST(ListEqualsTest, SizeLarger) {
+  static const int origin[]    = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  static const int reference[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_FALSE(list_equals(&l, reference, std::size(reference)));
+
+  list_destroy(&l);
+}
+
+TEST(ListEqualsTest, Empty) {
+  static const int reference[] = { 1 };
+
+  struct list l;
+  list_create(&l);
+
+  EXPECT_TRUE(list_equals(&l, reference, 0));
+  EXPECT_FALSE(list_equals(&l, reference, std::size(reference)));
+
+  list_destroy(&l);
+}
+
+/*
+ * list_recount
+ */
+
+TEST(ListRecountTest, LinkedByHand) {
+  static const int origin[] = { 1, 2, 3 };
+  static const int expected[] = { 1, 2, 3, 4 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list_node *node = static_cast<struct list_node *>(std::malloc(sizeof(struct list_node)));
+  node->data = 4;
+  node->next = nullptr;
+  node->prev = l.last;
+  l.last->next = node;
+  l.last = node;
+
+  list_recount(&l);
+
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+
+  list_destroy(&l);
+}
+
+/*
+ * list_push_front
+ */
+
+TEST(ListPushFrontTest, OneElement) {
+  struct list l;
+  list_create(&l);
+
+  list_push_front(&l, 1);
+
+  EXPECT_FALSE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), 1u);
+  EXPECT_EQ(list_get(&l, 0), 1);
+  EXPECT_EQ(l.first, l.last);
+
+
+  list_destroy(&l);
+}
+
+
+TEST(ListPushFrontTest, ManyElements) {
+  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
+
+  struct list l;
+  list_create(&l);
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    list_push_front(&l, origin[std::size(origin) - i - 1]);
+  }
+
+  EXPECT_FALSE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    EXPECT_EQ(list_get(&l, i), origin[i]);
+  }
+
+  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
+
+  list_destroy(&l);
+}
+
+
+TEST(ListPushFrontTest, Stressed) {
+  struct list l;
+  list_create(&l);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    list_push_front(&l, i + 1);
+    EXPECT_EQ(list_get(&l, 0), i + 1);
+    EXPECT_EQ(list_size(&l), static_cast<std::size_t>(i + 1));
+  }
+
+  EXPECT_FALSE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), static_cast<std::size_t>(BIG_SIZE));
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    EXPECT_EQ(list_get(&l, BIG_SIZE - i - 1), i + 1);
+  }
+
+  list_destroy(&l);
+}
+
+/*
+ * list_pop_front
+ */
+
+TEST(ListPopFrontTest, OneElement) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  list_pop_front(&l);
+
+  EXPECT_EQ(list_size(&l), std::size(origin) - 1);
+
+  for (std::size_t i = 0; i < std::size(origin) - 1; ++i) {
+    EXPECT_EQ(list_get(&l, i), origin[i + 1]);
+  }
+
+  list_destroy(&l);
+}
+
+TEST(ListPopFrontTest, ManyElements) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    list_pop_front(&l);
+  }
+
+  EXPECT_TRUE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), 0u);
+
+  list_destroy(&l);
+}
+
+/*
+ * list_push_back
+ */
+
+TEST(ListPushBackTest, OneElement) {
+  struct list l;
+  list_create(&l);
+
+  list_push_back(&l, 1);
+
+  EXPECT_FALSE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), 1u);
+  EXPECT_EQ(list_get(&l, 0), 1);
+  EXPECT_EQ(l.first, l.last);
+
+
+  list_destroy(&l);
+}
+
+
+TEST(ListPushBackTest, ManyElements) {
+  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
+
+  struct list l;
+  list_create(&l);
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    list_push_back(&l, origin[i]);
+  }
+
+  EXPECT_FALSE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    EXPECT_EQ(list_get(&l, i), origin[i]);
+  }
+
+  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
+
+  list_destroy(&l);
+}
+
+
+TEST(ListPushBackTest, Stressed) {
+  struct list l;
+  list_create(&l);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    list_push_back(&l, i + 1);
+    EXPECT_EQ(list_get(&l, i), i + 1);
+    EXPECT_EQ(list_size(&l), static_cast<std::size_t>(i + 1));
+  }
+
+  EXPECT_FALSE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), static_cast<std::size_t>(BIG_SIZE));
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    EXPECT_EQ(list_get(&l, i), i + 1);
+  }
+
+  list_destroy(&l);
+}
+
+/*
+ * list_pop_back
+ */
+
+TEST(ListPopBackTest, OneElement) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  list_pop_back(&l);
+
+  EXPECT_EQ(list_size(&l), std::size(origin) - 1);
+
+  for (std::size_t i = 0; i < std::size(origin) - 1; ++i) {
+    EXPECT_EQ(list_get(&l, i), origin[i]);
+  }
+
+  list_destroy(&l);
+}
+
+TEST(ListPopBackTest, ManyElements) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    list_pop_back(&l);
+  }
+
+  EXPECT_TRUE(list_empty(&l));
+  EXPECT_EQ(list_size(&l), 0u);
+
+  list_destroy(&l);
+}
+
+TEST(ListPopBackTest, Stressed) {
+  struct list l;
+  list_create(&l);
+
+  for (int i = 0; i < 1000 * BIG_SIZE; ++i) {
+    list_push_back(&l, i);
+  }
+
+  EXPECT_EQ(list_size(&l), static_cast<std::size_t>(1000 * BIG_SIZE));
+
+  for (int i = 1000 * BIG_SIZE - 1; i >= 0; --i) {
+    EXPECT_EQ(l.last->data, i);
+    list_pop_back(&l);
+    ASSERT_EQ(list_size(&l), static_cast<std::size_t>(i));
+  }
+
+  EXPECT_TRUE(list_empty(&l));
+
+  list_destroy(&l);
+}
+
+/*
+ * list_insert
+ */
+
+TEST(ListInsertTest, Beginning) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+  static const int expected[] = { 42, 9, 3, 7, 2, 4, 0, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  list_insert(&l, 42, 0); // insert at the beginning
+
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+
+  list_destroy(&l);
+}
+
+TEST(ListInsertTest, Middle) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+  static const int expected[] = { 9, 3, 7, 42, 2, 4, 0, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  list_insert(&l, 42, 3); // insert in the middle
+
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+
+  list_destroy(&l);
+}
+
+TEST(ListInsertTest, End) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+  static const int expected[] = { 9, 3, 7, 2, 4, 0, 8, 42 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  list_insert(&l, 42, std::size(origin)); // insert at the end
+
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+
+  list_destroy(&l);
+}
+
+TEST(ListInsertTest, Stressed) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    list_insert(&l, i + 1, 4);
+    EXPECT_EQ(list_size(&l), std::size(origin) + i + 1);
+  }
+
+  list_destroy(&l);
+}
+
+/*
+ * list_remove
+ */
+
+TEST(ListRemoveTest, Beginning) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+  static const int expected[] = { 3, 7, 2, 4, 0, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  list_remove(&l, 0); // remove at the beginning
+
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+
+  list_destroy(&l);
+}
+
+TEST(ListRemoveTest, Middle) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+  static const int expected[] = { 9, 3, 7, 4, 0, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  list_remove(&l, 3); // remove in the middle
+
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+
+  list_destroy(&l);
+}
+
+TEST(ListRemoveTest, End) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+  static const int expected[] = { 9, 3, 7, 2, 4, 0 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  list_remove(&l, std::size(origin) - 1); // remove at the end
+
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+
+  list_destroy(&l);
+}
+
+/*
+ * list_get
+ */
+
+TEST(ListGetTest, ValidIndex) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    EXPECT_EQ(list_get(&l, i), origin[i]);
+  }
+
+  list_destroy(&l);
+}
+
+TEST(ListGetTest, NotValidIndex) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_EQ(list_get(&l, std::size(origin)), 0);
+  EXPECT_EQ(list_get(&l, -1), 0);
+
+  list_destroy(&l);
+}
+
+TEST(ListGetTest, Stressed) {
+  struct list l;
+  list_create(&l);
+
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    list_push_back(&l, i);
+  }
+
+  for (int i = 0; i < 10 * BIG_SIZE; i += 7) {
+    EXPECT_EQ(list_get(&l, i), i);
+  }
+
+  list_remove(&l, 10 * BIG_SIZE - 2);
+  list_insert(&l, -1, 10 * BIG_SIZE - 3);
+  EXPECT_EQ(list_get(&l, 10 * BIG_SIZE - 3), -1);
+  EXPECT_EQ(list_get(&l, 10 * BIG_SIZE - 2), 10 * BIG_SIZE - 3);
+  EXPECT_EQ(list_get(&l, 10 * BIG_SIZE - 1), 10 * BIG_SIZE - 1);
+  EXPECT_EQ(list_size(&l), static_cast<std::size_t>(10 * BIG_SIZE));
+
+  list_destroy(&l);
+}
+
+/*
+ * list_set
+ */
+
+TEST(ListSetTest, ValidIndex) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    list_set(&l, i, origin[i] - 1);
+    EXPECT_EQ(list_get(&l, i), origin[i] - 1);
+  }
+
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  list_destroy(&l);
+}
+
+TEST(ListSetTest, NotValidIndex) {
+  static const int origin[] = { 9, 3, 7, 2, 4, 0, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  list_set(&l, std::size(origin), 42);
+  list_set(&l, -1, 42);
+
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    EXPECT_EQ(list_get(&l, i), origin[i]);
+  }
+
+  list_destroy(&l);
+}
+
+TEST(ListSetTest, OneElement) {
+  static const int origin[] = { 1 };
+  static const int expected[] = { 42 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  list_set(&l, 0, 42);
+
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+
+  list_destroy(&l);
+}
+
+/*
+ * list_search
+ */
+
+TEST(ListSearchTest, Present) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  for (size_t i = 0; i < std::size(origin); ++i) {
+    size_t index = list_search(&l, origin[i]);
+    EXPECT_EQ(index, i);
+  }
+
+  list_destroy(&l);
+}
+
+TEST(ListSearchTest, NotPresent) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  size_t index = list_search(&l, -1);
+  EXPECT_EQ(index, std::size(origin));
+
+  list_destroy(&l);
+}
+
+/*
+ * list_is_sorted
+ */
+
+TEST(ListIsSortedTest, Empty) {
+  struct list l;
+  list_create(&l);
+
+  EXPECT_TRUE(list_is_sorted(&l));
+
+  list_destroy(&l);
+}
+
+TEST(ListIsSortedTest, Sorted) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_TRUE(list_is_sorted(&l));
+
+  list_destroy(&l);
+}
+
+TEST(ListIsSortedTest, NotSorted) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 10, 9, 8, 7, 6 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_FALSE(list_is_sorted(&l));
+
+  list_destroy(&l);
+}
+
+TEST(ListIsSortedTest, NotSortedAtTheEnd) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_FALSE(list_is_sorted(&l));
+
+  list_destroy(&l);
+}
+
+/*
+ * list_split
+ */
+
+TEST(ListSplitTest, EvenSize) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  assert(std::size(origin) % 2 == 0);
+
+  std::size_t half = std::size(origin) / 2;
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list l1;
+  list_create(&l1);
+
+  struct list l2;
+  list_create(&l2);
+
+  list_split(&l, &l1, &l2);
+
+  EXPECT_TRUE(list_empty(&l));
+  EXPECT_EQ(list_size(&l1), half);
+  EXPECT_EQ(list_size(&l2), half);
+
+  for (auto val : origin) {
+    EXPECT_TRUE(list_search(&l1, val) != half || list_search(&l2, val) != half);
+  }
+
+  list_destroy(&l2);
+  list_destroy(&l1);
+  list_destroy(&l);
+}
+
+
+TEST(ListSplitTest, OddSize) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+  assert(std::size(origin) % 2 == 1);
+
+  std::size_t half = std::size(origin) / 2;
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list l1;
+  list_create(&l1);
+
+  struct list l2;
+  list_create(&l2);
+
+  list_split(&l, &l1, &l2);
+
+  std::size_t sz1 = list_size(&l1);
+  std::size_t sz2 = list_size(&l2);
+
+  EXPECT_TRUE(list_empty(&l));
+  EXPECT_EQ(sz1 + sz2, std::size(origin));
+
+  EXPECT_TRUE((sz1 == half && sz2 == half + 1) || (sz1 == half + 1 && sz2 == half));
+
+  for (auto val : origin) {
+    EXPECT_TRUE(list_search(&l1, val) != sz1 || list_search(&l2, val) != sz2);
+  }
+
+  list_destroy(&l2);
+  list_destroy(&l1);
+  list_destroy(&l);
+}
+
+/*
+ * list_merge
+ */
+
+TEST(ListMergeTest, BothNonEmpty) {
+  static const int origin1[] = { 0, 1, 3, 6, 10 };
+  static const int origin2[] = { 2, 4, 5, 7, 8, 9 };
+  static const int expected[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+
+  struct list l;
+  list_create(&l);
+
+  struct list l1;
+  list_create_from(&l1, origin1, std::size(origin1));
+
+  struct list l2;
+  list_create_from(&l2, origin2, std::size(origin2));
+
+  list_merge(&l, &l1, &l2);
+
+  EXPECT_TRUE(list_empty(&l1));
+  EXPECT_TRUE(list_empty(&l2));
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+
+  list_destroy(&l2);
+  list_destroy(&l1);
+  list_destroy(&l);
+}
+
+TEST(ListMergeTest, FirstEmpty) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+
+  struct list l;
+  list_create(&l);
+
+  struct list l1;
+  list_create(&l1);
+
+  struct list l2;
+  list_create_from(&l2, origin, std::size(origin));
+
+  list_merge(&l, &l1, &l2);
+
+  EXPECT_TRUE(list_empty(&l1));
+  EXPECT_TRUE(list_empty(&l2));
+  EXPECT_EQ(list_size(&l), std::size(origin));
+  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
+
+  list_destroy(&l2);
+  list_destroy(&l1);
+  list_destroy(&l);
+}
+
+TEST(ListMergeTest, SecondEmpty) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+
+  struct list l;
+  list_create(&l);
+
+  struct list l1;
+  list_create_from(&l1, origin, std::size(origin));
+
+  struct list l2;
+  list_create(&l2);
+
+  list_merge(&l, &l1, &l2);
+
+  EXPECT_TRUE(list_empty(&l1));
+  EXPECT_TRUE(list_empty(&l2));
+  EXPECT_EQ(list_size(&l), std::size(origin));
+  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
+
+  list_destroy(&l2);
+  list_destroy(&l1);
+  list_destroy(&l);
+}
+
+/*
+ * list_merge_sort
+ */
+
+TEST(ListMergeSortTest, NotSorted) {
+  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_FALSE(list_is_sorted(&l));
+
+  list_merge_sort(&l);
+
+  EXPECT_TRUE(list_is_sorted(&l));
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  for (int val : origin) {
+    EXPECT_NE(list_search(&l, val), std::size(origin));
+  }
+
+  list_destroy(&l);
+}
+
+TEST(ListMergeSortTest, SortedBackward) {
+  static const int origin[] = { 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_FALSE(list_is_sorted(&l));
+
+  list_merge_sort(&l);
+
+  EXPECT_TRUE(list_is_sorted(&l));
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  for (int val : origin) {
+    EXPECT_NE(list_search(&l, val), std::size(origin));
+  }
+
+  list_destroy(&l);
+}
+
+TEST(ListMergeSortTest, Sorted) {
+  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  EXPECT_TRUE(list_is_sorted(&l));
+
+  list_merge_sort(&l);
+
+  EXPECT_TRUE(list_is_sorted(&l));
+  EXPECT_EQ(list_size(&l), std::size(origin));
+
+  for (int val : origin) {
+    EXPECT_NE(list_search(&l, val), std::size(origin));
+  }
+
+  list_destroy(&l);
+}
+
+TEST(ListMergeSortTest, Stressed) {
+  std::vector<int> origin;
+  std::srand(0);
+
+  for (int i = 0; i < 100 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % BIG_SIZE);
+  }
+
+  struct list l;
+  list_create_from(&l, origin.data(), origin.size());
+
+  list_merge_sort(&l);
+
+  std::sort(origin.begin(), origin.end());
+  EXPECT_EQ(list_size(&l), origin.size());
+  EXPECT_TRUE(list_equals(&l, origin.data(), origin.size()));
+
+  std::size_t count = 0;
+
+  for (struct list_node *node = l.last; node != nullptr; node = node->prev) {
+    ++count;
+  }
+
+  EXPECT_EQ(count, origin.size());
+  EXPECT_EQ(l.first->prev, nullptr);
+  EXPECT_EQ(l.last->next, nullptr);
+
+  list_destroy(&l);
+}
+
+TEST(ListMergeSortTest, Runs) {
+  std::vector<int> origin;
+
+  for (int run = 0; run < 10; ++run) {
+    for (int i = 0; i < BIG_SIZE; ++i) {
+      origin.push_back(run % 2 == 0 ? i * 10 + run : (BIG_SIZE - i) * 10 + run);
+    }
+  }
+
+  struct list l;
+  list_create_from(&l, origin.data(), origin.size());
+
+  struct list_node *first = l.first;
+  list_merge_sort(&l);
+
+  std::sort(origin.begin(), origin.end());
+  EXPECT_TRUE(list_equals(&l, origin.data(), origin.size()));
+  EXPECT_EQ(first, l.first); // nodes are relinked, not reallocated
+
+  list_destroy(&l);
+}
+
+/*
+ * list_cursor
+ */
+
+TEST(ListCursorTest, Forward) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list_cursor c;
+  std::size_t i = 0;
+
+  for (list_cursor_begin(&c, &l); list_cursor_valid(&c); list_cursor_next(&c)) {
+    EXPECT_EQ(list_cursor_get(&c), origin[i]);
+    ++i;
+  }
+
+  EXPECT_EQ(i, std::size(origin));
+
+  list_destroy(&l);
+}
+
+TEST(ListCursorDeathTest, BeforeFirst) {
+  static const int origin[] = { 1, 2, 3 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list_cursor c;
+  list_cursor_begin(&c, &l);
+
+  EXPECT_DEATH(list_cursor_prev(&c), "before the first element");
+
+  list_destroy(&l);
+}
+
+TEST(ListCursorTest, Backward) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list_cursor c;
+  std::size_t i = std::size(origin);
+
+  list_cursor_end(&c, &l);
+
+  while (i > 0) {
+    list_cursor_prev(&c);
+    --i;
+    EXPECT_TRUE(list_cursor_valid(&c));
+    EXPECT_EQ(list_cursor_get(&c), origin[i]);
+    list_cursor_set(&c, -origin[i]);
+  }
+
+  EXPECT_EQ(c.node, l.first);
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    EXPECT_EQ(list_get(&l, i), -origin[i]);
+  }
+
+  list_destroy(&l);
+}
+
+TEST(ListCursorTest, InsertBefore) {
+  static const int origin[] = { 2, 4, 6 };
+  static const int expected[] = { 1, 2, 3, 4, 5, 6, 7 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list_cursor c;
+
+  for (list_cursor_begin(&c, &l); list_cursor_valid(&c); list_cursor_next(&c)) {
+    list_cursor_insert_before(&c, list_cursor_get(&c) - 1);
+  }
+
+  list_cursor_insert_before(&c, 7); // past the end
+
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+  EXPECT_EQ(l.last->data, 7);
+
+  list_destroy(&l);
+}
+
+TEST(ListCursorTest, Erase) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  static const int expected[] = { 2, 4, 6, 8 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list_cursor c;
+  list_cursor_begin(&c, &l);
+
+  while (list_cursor_valid(&c)) {
+    if (list_cursor_get(&c) % 2 == 1) {
+      list_cursor_erase(&c);
+    } else {
+      list_cursor_next(&c);
+    }
+  }
+
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+  EXPECT_EQ(l.first->prev, nullptr);
+  EXPECT_EQ(l.last->data, 8);
+
+  list_destroy(&l);
+}
+
+TEST(ListCursorTest, At) {
+  static const int origin[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list_cursor c;
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    list_cursor_at(&c, &l, i);
+    EXPECT_EQ(list_cursor_get(&c), origin[i]);
+  }
+
+  list_cursor_at(&c, &l, std::size(origin));
+  EXPECT_FALSE(list_cursor_valid(&c));
+
+  list_destroy(&l);
+}
+
+TEST(ListCursorTest, Index) {
+  static const int origin[] = { 1, 2, 3, 4, 5 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list_cursor c;
+  list_cursor_begin(&c, &l);
+  EXPECT_EQ(c.index, 0u);
+
+  list_cursor_next(&c);
+  list_cursor_next(&c);
+  EXPECT_EQ(c.index, 2u);
+
+  list_cursor_insert_before(&c, 42);
+  EXPECT_EQ(c.index, 3u);
+  EXPECT_EQ(list_get(&l, c.index), list_cursor_get(&c));
+
+  list_cursor_erase(&c);
+  EXPECT_EQ(c.index, 3u);
+  EXPECT_EQ(list_get(&l, c.index), list_cursor_get(&c));
+
+  list_cursor_end(&c, &l);
+  EXPECT_EQ(c.index, list_size(&l));
+
+  list_cursor_prev(&c);
+  EXPECT_EQ(c.index, list_size(&l) - 1);
+
+  list_destroy(&l);
+}
+
+/*
+ * list_splice
+ */
+
+TEST(ListSpliceTest, Middle) {
+  static const int origin[] = { 1, 2, 6, 7 };
+  static const int other_origin[] = { 3, 4, 5 };
+  static const int expected[] = { 1, 2, 3, 4, 5, 6, 7 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list other;
+  list_create_from(&other, other_origin, std::size(other_origin));
+
+  struct list_cursor c;
+  list_cursor_at(&c, &l, 2);
+  list_splice(&c, &other);
+
+  EXPECT_TRUE(list_empty(&other));
+  EXPECT_EQ(list_size(&other), 0u);
+  EXPECT_EQ(list_size(&l), std::size(expected));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+  EXPECT_EQ(list_cursor_get(&c), 6);
+  EXPECT_EQ(c.index, 5u);
+
+  std::size_t count = 0;
+
+  for (struct list_node *node = l.last; node != nullptr; node = node->prev) {
+    ++count;
+  }
+
+  EXPECT_EQ(count, std::size(expected));
+
+  list_destroy(&other);
+  list_destroy(&l);
+}
+
+TEST(ListSpliceTest, Beginning) {
+  static const int origin[] = { 4, 5 };
+  static const int other_origin[] = { 1, 2, 3 };
+  static const int expected[] = { 1, 2, 3, 4, 5 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list other;
+  list_create_from(&other, other_origin, std::size(other_origin));
+
+  struct list_cursor c;
+  list_cursor_begin(&c, &l);
+  list_splice(&c, &other);
+
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+  EXPECT_EQ(l.first->prev, nullptr);
+
+  list_destroy(&other);
+  list_destroy(&l);
+}
+
+TEST(ListSpliceTest, EmptyList) {
+  static const int other_origin[] = { 1, 2, 3 };
+
+  struct list l;
+  list_create(&l);
+
+  struct list other;
+  list_create_from(&other, other_origin, std::size(other_origin));
+
+  struct list_cursor c;
+  list_cursor_end(&c, &l);
+  list_splice(&c, &other);
+
+  EXPECT_TRUE(list_equals(&l, other_origin, std::size(other_origin)));
+  EXPECT_TRUE(list_empty(&other));
+
+  list_splice(&c, &other); // nothing to move
+
+  EXPECT_TRUE(list_equals(&l, other_origin, std::size(other_origin)));
+
+  list_destroy(&other);
+  list_destroy(&l);
+}
+
+/*
+ * list_concat
+ */
+
+TEST(ListConcatTest, BothNonEmpty) {
+  static const int origin[] = { 1, 2, 3 };
+  static const int other_origin[] = { 4, 5 };
+  static const int expected[] = { 1, 2, 3, 4, 5 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list other;
+  list_create_from(&other, other_origin, std::size(other_origin));
+
+  list_concat(&l, &other);
+
+  EXPECT_TRUE(list_empty(&other));
+  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+  EXPECT_EQ(l.last->data, 5);
+  EXPECT_EQ(l.last->next, nullptr);
+
+  list_destroy(&other);
+  list_destroy(&l);
+}
+
+/*
+ * list_split_at
+ */
+
+TEST(ListSplitAtTest, Middle) {
+  static const int origin[] = { 1, 2, 3, 4, 5 };
+  static const int expected1[] = { 1, 2 };
+  static const int expected2[] = { 0, 3, 4, 5 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list out;
+  list_create(&out);
+  list_push_back(&out, 0);
+
+  struct list_cursor c;
+  list_cursor_at(&c, &l, 2);
+  list_split_at(&c, &out);
+
+  EXPECT_FALSE(list_cursor_valid(&c));
+  EXPECT_TRUE(list_equals(&l, expected1, std::size(expected1)));
+  EXPECT_TRUE(list_equals(&out, expected2, std::size(expected2)));
+  EXPECT_EQ(l.last->next, nullptr);
+  EXPECT_EQ(out.first->next->prev, out.first);
+
+  list_destroy(&out);
+  list_destroy(&l);
+}
+
+TEST(ListSplitAtTest, Beginning) {
+  static const int origin[] = { 1, 2, 3, 4, 5 };
+
+  struct list l;
+  list_create_from(&l, origin, std::size(origin));
+
+  struct list out;
+  list_create(&out);
+
+  struct list_cursor c;
+  list_cursor_begin(&c, &l);
+  list_split_at(&c, &out);
+
+  EXPECT_TRUE(list_empty(&l));
+  EXPECT_EQ(l.first, nullptr);
+  EXPECT_EQ(l.last, nullptr);
+  EXPECT_TRUE(list_equals(&out, origin, std::size(origin)));
+
+  list_split_at(&c, &out); // nothing to move
+
+  EXPECT_TRUE(list_equals(&out, origin, std::size(origin)));
+
+  list_destroy(&out);
+  list_destroy(&l);
+}
+
+/*
+ * ulist_create
+ */
+
+TEST(UlistCreateTest, Empty) {
+  struct ulist l;
+  ulist_create(&l);
+
+  EXPECT_TRUE(ulist_empty(&l));
+  EXPECT_EQ(ulist_size(&l), 0u);
+  EXPECT_TRUE(ulist_equals(&l, nullptr, 0));
+
+  ulist_destroy(&l);
+}
+
+TEST(UlistCreateTest, NodeSize) {
+  EXPECT_EQ(sizeof(struct ulist_node), static_cast<std::size_t>(ULIST_NODE_SIZE));
+  EXPECT_GE(ULIST_NODE_CAPACITY, 16u);
+  EXPECT_LE(ULIST_NODE_CAPACITY, 60u);
+}
+
+TEST(UlistCreateTest, From) {
+  std::vector<int> origin;
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    origin.push_back(i * 3);
+  }
+
+  struct ulist l;
+  ulist_create_from(&l, origin.data(), origin.size());
+
+  EXPECT_EQ(ulist_size(&l), origin.size());
+  EXPECT_TRUE(ulist_equals(&l, origin.data(), origin.size()));
+
+  origin.back() = -1;
+  EXPECT_FALSE(ulist_equals(&l, origin.data(), origin.size()));
+
+  ulist_destroy(&l);
+}
+
+/*
+ * ulist_push_front, ulist_push_back, ulist_pop_front, ulist_pop_back
+ */
+
+TEST(UlistPushPopTest, BothEnds) {
+  std::vector<int> reference;
+
+  struct ulist l;
+  ulist_create(&l);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    if (i % 3 == 0) {
+      ulist_push_front(&l, i);
+      reference.insert(reference.begin(), i);
+    } else {
+      ulist_push_back(&l, i);
+      reference.push_back(i);
+    }
+  }
+
+  EXPECT_TRUE(ulist_equals(&l, reference.data(), reference.size()));
+
+  while (!reference.empty()) {
+    if (reference.size() % 2 == 0) {
+      ulist_pop_front(&l);
+      reference.erase(reference.begin());
+    } else {
+      ulist_pop_back(&l);
+      reference.pop_back();
+    }
+
+    ASSERT_TRUE(ulist_equals(&l, reference.data(), reference.size()));
+  }
+
+  EXPECT_TRUE(ulist_empty(&l));
+  EXPECT_EQ(l.first, nullptr);
+  EXPECT_EQ(l.last, nullptr);
+
+  ulist_destroy(&l);
+}
+
+/*
+ * ulist_insert, ulist_remove
+ */
+
+TEST(UlistInsertRemoveTest, Stressed) {
+  std::vector<int> reference;
+
+  struct ulist l;
+  ulist_create(&l);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    std::size_t index = (static_cast<std::size_t>(i) * 7919) % (reference.size() + 1);
+    ulist_insert(&l, i, index);
+    reference.insert(reference.begin() + index, i);
+  }
+
+  EXPECT_TRUE(ulist_equals(&l, reference.data(), reference.size()));
+
+  for (std::size_t i = 0; i < reference.size(); ++i) {
+    EXPECT_EQ(ulist_get(&l, i), reference[i]);
+  }
+
+  while (!reference.empty()) {
+    std::size_t index = (reference.size() * 7) / 11;
+    ulist_remove(&l, index);
+    reference.erase(reference.begin() + index);
+
+    ASSERT_EQ(ulist_size(&l), reference.size());
+  }
+
+  EXPECT_TRUE(ulist_empty(&l));
+
+  ulist_destroy(&l);
+}
+
+TEST(UlistInsertRemoveTest, NodesStayFilled) {
+  std::vector<int> origin;
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    origin.push_back(i);
+  }
+
+  struct ulist l;
+  ulist_create_from(&l, origin.data(), origin.size());
+
+  for (std::size_t i = 0; i < origin.size() / 2; ++i) {
+    ulist_remove(&l, i);
+  }
+
+  std::size_t nodes = 0;
+
+  for (struct ulist_node *node = l.first; node != nullptr; node = node->next) {
+    EXPECT_GT(node->count, 0u);
+    ++nodes;
+  }
+
+  // A node under half full is merged into a neighbour when they fit, so nodes are half full on average
+  EXPECT_LE(nodes, 2 * ulist_size(&l) / ULIST_NODE_CAPACITY + 2);
+
+  ulist_destroy(&l);
+}
+
+/*
+ * ulist_get, ulist_set
+ */
+
+TEST(UlistGetSetTest, InvalidIndex) {
+  static const int origin[] = { 1, 2, 3 };
+
+  struct ulist l;
+  ulist_create_from(&l, origin, std::size(origin));
+
+  EXPECT_EQ(ulist_get(&l, 3), 0);
+  ulist_set(&l, 3, 42);
+  EXPECT_TRUE(ulist_equals(&l, origin, std::size(origin)));
+
+  ulist_set(&l, 1, 42);
+  EXPECT_EQ(ulist_get(&l, 1), 42);
+
+  ulist_destroy(&l);
+}
+
+/*
+ * ulist_search
+ */
+
+TEST(UlistSearchTest, Stressed) {
+  std::vector<int> origin;
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    origin.push_back(i * 2);
+  }
+
+  struct ulist l;
+  ulist_create_from(&l, origin.data(), origin.size());
+
+  for (std::size_t i = 0; i < origin.size(); ++i) {
+    EXPECT_EQ(ulist_search(&l, origin[i]), i);
+    EXPECT_EQ(ulist_search(&l, origin[i] + 1), ulist_size(&l));
+  }
+
+  ulist_destroy(&l);
+}
+
+/*
+ * ulist_merge_sort
+ */
+
+TEST(UlistMergeSortTest, Stressed) {
+  std::vector<int> origin;
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    origin.push_back((i * 7919) % 257 - 128);
+  }
+
+  struct ulist l;
+  ulist_create(&l);
+
+  for (int value : origin) {
+    ulist_push_front(&l, value);
+  }
+
+  EXPECT_FALSE(ulist_is_sorted(&l));
+
+  ulist_merge_sort(&l);
+
+  std::sort(origin.begin(), origin.end());
+  EXPECT_TRUE(ulist_is_sorted(&l));
+  EXPECT_TRUE(ulist_equals(&l, origin.data(), origin.size()));
+
+  ulist_destroy(&l);
+}
+
+TEST(UlistMergeSortTest, Small) {
+  static const int origin[] = { 3, 1, 2 };
+  static const int expected[] = { 1, 2, 3 };
+
+  struct ulist l;
+  ulist_create_from(&l, origin, std::size(origin));
+  ulist_merge_sort(&l);
+
+  EXPECT_TRUE(ulist_equals(&l, expected, std::size(expected)));
+
+  ulist_destroy(&l);
+}
+
+/*
+ * tree_create
+ */
+
+TEST(TreeCreateTest, Empty) {
+  struct tree t;
+
+  tree_create(&t);
+
+  EXPECT_TRUE(tree_empty(&t));
+  EXPECT_EQ(tree_size(&t), 0u);
+  EXPECT_EQ(tree_height(&t), 0u);
+
+  tree_destroy(&t);
+}
+
+
+TEST(TreeCreateTest, WithPool) {
+  struct node_pool pool;
+  node_pool_create(&pool, sizeof(struct tree_node), false);
+
+  struct tree t;
+  tree_create_with_pool(&t, &pool);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    tree_insert(&t, (i * 7919) % BIG_SIZE);
+  }
+
+  for (int i = 0; i < BIG_SIZE; i += 3) {
+    tree_remove(&t, i);
+  }
+
+  EXPECT_EQ(tree_size(&t), pool.live);
+
+  tree_destroy(&t);
+
+  EXPECT_TRUE(tree_empty(&t));
+  EXPECT_EQ(pool.slabs, nullptr);
+
+  node_pool_destroy(&pool);
+}
+
+/*
+ * tree_insert
+ */
+
+TEST(TreeInsertTest, OneElement) {
+  struct tree t;
+
+  tree_create(&t);
+  bool inserted = tree_insert(&t, 0);
+
+  EXPECT_TRUE(inserted);
+  EXPECT_FALSE(tree_empty(&t));
+  EXPECT_EQ(tree_size(&t), 1u);
+  EXPECT_EQ(tree_height(&t), 1u);
+  EXPECT_TRUE(tree_contains(&t, 0));
+
+  tree_destroy(&t);
+}
+
+TEST(TreeInsertTest, TwoElements) {
+  struct tree t;
+
+  tree_create(&t);
+  bool inserted1 = tree_insert(&t, 1);
+  bool inserted2 = tree_insert(&t, 2);
+
+  EXPECT_TRUE(inserted1);
+  EXPECT_TRUE(inserted2);
+  EXPECT_FALSE(tree_empty(&t));
+  EXPECT_EQ(tree_size(&t), 2u);
+  EXPECT_EQ(tree_height(&t), 2u);
+  EXPECT_TRUE(tree_contains(&t, 1));
+  EXPECT_TRUE(tree_contains(&t, 2));
+
+  tree_destroy(&t);
+}
+
+TEST(TreeInsertTest, AlreadyPresent) {
+  struct tree t;
+  tree_create(&t);
+
+  bool inserted1 = tree_insert(&t, 5);
+
+  EXPECT_TRUE(inserted1);
+
+  bool inserted2 = tree_insert(&t, 7);
+
+  EXPECT_TRUE(inserted2);
+
+  bool inserted3 = tree_insert(&t, 7); // already present
+
+  EXPECT_FALSE(inserted3);
+  EXPECT_FALSE(tree_empty(&t));
+  EXPECT_EQ(tree_size(&t), 2u);
+  EXPECT_EQ(tree_height(&t), 2u);
+  EXPECT_TRUE(tree_contains(&t, 5));
+  EXPECT_TRUE(tree_contains(&t, 7));
+
+  tree_destroy(&t);
+}
+
+
+TEST(TreeInsertTest, ManyElements) {
+  static const int values[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+
+  struct tree t;
+  tree_create(&t);
+
+  for (std::size_t i = 0; i < std::size(values); ++i) {
+    bool inserted = tree_insert(&t, values[i]);
+    EXPECT_TRUE(inserted);
+  }
+
+  for (std::size_t i = 0; i < std::size(values); ++i) {
+    EXPECT_TRUE(tree_contains(&t, values[i]));
+  }
+
+  for (int i = 1; i <= 19; i += 2) {
+    EXPECT_FALSE(tree_contains(&t, i));
+  }
+
+  tree_destroy(&t);
+}
+
+static size_t log_2(size_t x) {
+  size_t res = 0;
+
+  while (x != 0) {
+    res++;
+    x /= 2;
+  }
+
+  return res;
+}
+
+TEST(TreeInsertTest, Stressed) {
+  struct tree t;
+  tree_create(&t);
+
+  std::size_t expected = 0;
+  std::srand(0);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    int value = std::rand();
+
+    if (tree_insert(&t, value)) {
+      ++expected;
+    }
+
+    EXPECT_EQ(tree_size(&t), expected);
+  }
+
+  EXPECT_FALSE(tree_empty(&t));
+
+  size_t size = tree_size(&t);
+  size_t height = tree_height(&t);
+
+  EXPECT_EQ(size, expected);
+  EXPECT_LE(height, size);
+  EXPECT_LE(log_2(size + 1), height);
+
+  tree_destroy(&t);
+}
+
+// Check the ordering and the balancing invariant, and return the height (AVL) or the black height (red-black)
+static int check_balanced(const struct tree_node *node, long low, long high) {
+  if (node == nullptr) {
+    return 0;
+  }
+
+  EXPECT_LT(low, node->data);
+  EXPECT_LT(node->data, high);
+
+  int left = check_balanced(node->left, low, node->data);
+  int right = check_balanced(node->right, node->data, high);
+
+  std::size_t size = 1 + (node->left == nullptr ? 0 : node->left->size) + (node->right == nullptr ? 0 : node->right->size);
+  EXPECT_EQ(node->size, size);
+
+#ifdef TREE_RED_BLACK
+  if (node->balance == 1) {
+    EXPECT_TRUE(node->left == nullptr || node->left->balance == 0);
+    EXPECT_TRUE(node->right == nullptr || node->right->balance == 0);
+  }
+
+  EXPECT_EQ(left, right);
+  return left + (node->balance == 0 ? 1 : 0);
+#else
+  EXPECT_LE(std::abs(left - right), 1);
+  EXPECT_EQ(node->balance, 1 + std::max(left, right));
+  return 1 + std::max(left, right);
+#endif
+}
+
+static void check_balanced(const struct tree *t) {
+  check_balanced(t->root, static_cast<long>(INT_MIN) - 1, static_cast<long>(INT_MAX) + 1);
+}
+
+TEST(TreeInsertTest, SortedKeys) {
+  static const int size = 100 * BIG_SIZE;
+
+  struct tree t;
+  tree_create(&t);
+
+  for (int i = 0; i < size; ++i) {
+    EXPECT_TRUE(tree_insert(&t, i));
+  }
+
+  EXPECT_EQ(tree_size(&t), static_cast<std::size_t>(size));
+  EXPECT_LE(tree_height(&t), 2 * log_2(size + 1));
+  check_balanced(&t);
+
+  for (int i = size - 1; i >= 0; --i) {
+    EXPECT_TRUE(tree_insert(&t, -i - 1));
+  }
+
+  EXPECT_LE(tree_height(&t), 2 * log_2(2 * size + 1));
+  check_balanced(&t);
+
+  tree_destroy(&t);
+}
+
+/*
+ * tree_insert_or_get
+ */
+
+TEST(TreeInsertOrGetTest, Present) {
+  struct tree t;
+  tree_create(&t);
+
+  bool inserted = false;
+  const struct tree_node *node = tree_insert_or_get(&t, 42, &inserted);
+
+  ASSERT_NE(node, nullptr);
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(node->data, 42);
+
+  EXPECT_EQ(tree_insert_or_get(&t, 42, &inserted), node);
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(tree_size(&t), 1u);
+
+  EXPECT_EQ(tree_insert_or_get(&t, 42, nullptr), node);
+
+  tree_destroy(&t);
+}
+
+TEST(TreeInsertOrGetTest, NodeStaysValid) {
+  struct tree t;
+  tree_create(&t);
+
+  const struct tree_node *node = tree_insert_or_get(&t, BIG_SIZE, nullptr);
+
+  for (int i = 0; i < 2 * BIG_SIZE; ++i) {
+    tree_insert(&t, i);
+  }
+
+  for (int i = 0; i < 2 * BIG_SIZE; ++i) {
+    if (i != BIG_SIZE) {
+      tree_remove(&t, i);
+    }
+  }
+
+  EXPECT_EQ(tree_size(&t), 1u);
+  EXPECT_EQ(t.root, node);
+  EXPECT_EQ(node->data, BIG_SIZE);
+
+  tree_destroy(&t);
+}
+
+/*
+ * tree_remove
+ */
+
+TEST(TreeRemoveTest, Empty) {
+  struct tree t;
+  tree_create(&t);
+
+  EXPECT_FALSE(tree_remove(&t, 0));
+  EXPECT_TRUE(tree_empty(&t));
+
+  tree_destroy(&t);
+}
+
+TEST(TreeRemoveTest, ManyElements) {
+  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+
+  struct tree t;
+  tree_create(&t);
+
+  for (int val : origin) {
+    tree_insert(&t, val);
+  }
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    EXPECT_TRUE(tree_contains(&t, origin[i]));
+
+    bool removed = tree_remove(&t, origin[i]);
+
+    EXPECT_TRUE(removed);
+    EXPECT_FALSE(tree_contains(&t, origin[i]));
+    EXPECT_EQ(tree_size(&t), std::size(origin) - i - 1);
+  }
+
+  tree_destroy(&t);
+}
+
+TEST(TreeRemoveTest, NotPresentBefore) {
+  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+
+  struct tree t;
+  tree_create(&t);
+
+  for (int val : origin) {
+    tree_insert(&t, val);
+  }
+
+  bool removed = tree_remove(&t, 1);
+
+  EXPECT_FALSE(removed);
+  EXPECT_EQ(tree_size(&t), std::size(origin));
+
+  tree_destroy(&t);
+}
+
+TEST(TreeRemoveTest, NotPresentMiddle) {
+  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+
+  struct tree t;
+  tree_create(&t);
+
+  for (int val : origin) {
+    tree_insert(&t, val);
+  }
+
+  bool removed = tree_remove(&t, 9);
+
+  EXPECT_FALSE(removed);
+  EXPECT_EQ(tree_size(&t), std::size(origin));
+
+  tree_destroy(&t);
+}
+
+TEST(TreeRemoveTest, NotPresentAfter) {
+  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+
+  struct tree t;
+  tree_create(&t);
+
+  for (int val : origin) {
+    tree_insert(&t, val);
+  }
+
+  bool removed = tree_remove(&t, 19);
+
+  EXPECT_FALSE(removed);
+  EXPECT_EQ(tree_size(&t), std::size(origin));
+
+  tree_destroy(&t);
+}
+
+TEST(TreeRemoveTest, Stressed) {
+  struct tree t;
+  tree_create(&t);
+
+  std::srand(0);
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    int value = rand();
+    tree_insert(&t, value);
+  }
+
+  size_t expected = tree_size(&t);
+  EXPECT_TRUE(expected > 0);
+
+  std::srand(0); // reinit
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    int value = rand();
+
+    bool present = tree_contains(&t, value);
+
+    if (present) {
+      --expected;
+    }
+
+    bool removed = tree_remove(&t, value);
+
+    EXPECT_EQ(present, removed);
+    EXPECT_EQ(tree_size(&t), expected);
+  }
+
+  EXPECT_EQ(tree_size(&t), 0u);
+
+  tree_destroy(&t);
+}
+
+TEST(TreeRemoveTest, Balanced) {
+  struct tree t;
+  tree_create(&t);
+
+  std::srand(0);
+
+  for (int round = 0; round < 10; ++round) {
+    for (int i = 0; i < BIG_SIZE; ++i) {
+      tree_insert(&t, std::rand() % (4 * BIG_SIZE));
+    }
+
+    for (int i = 0; i < BIG_SIZE; ++i) {
+      int value = std::rand() % (4 * BIG_SIZE);
+
+      if (tree_contains(&t, value)) {
+        EXPECT_TRUE(tree_remove(&t, value));
+        EXPECT_FALSE(tree_contains(&t, value));
+      }
+    }
+
+    check_balanced(&t);
+    EXPECT_LE(tree_height(&t), 2 * log_2(tree_size(&t) + 1));
+  }
+
+  for (int value = 0; value < 4 * BIG_SIZE; value += 2) {
+    if (tree_contains(&t, value)) {
+      tree_remove(&t, value);
+    }
+  }
+
+  check_balanced(&t);
+
+  tree_destroy(&t);
+}
+
+/*
+ * tree_walk_in_order
+ */
+
+static void check_tree(int value, void *user_data) {
+  int *expected = static_cast<int *>(user_data);
+
+  ASSERT_TRUE(expected != NULL);
+  EXPECT_EQ(*expected, value);
+
+  (*expected) += 2;
+}
+
+TEST(TreeWalkInOrderTest, Ordered) {
+  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+
+  struct tree t;
+  tree_create(&t);
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    tree_insert(&t, origin[i]);
+  }
+
+  EXPECT_EQ(tree_size(&t), std::size(origin));
+
+  int expected = 2;
+  tree_walk_in_order(&t, check_tree, &expected);
+  EXPECT_EQ(expected, 20);
+
+  tree_destroy(&t);
+}
+
+static void check_once(int value, void *user_data) {
+  int *count = static_cast<int *>(user_data);
+
+  ASSERT_TRUE(count != NULL);
+  ASSERT_TRUE(2 <= value && value <= 18);
+  EXPECT_EQ(count[value / 2], 0);
+
+  count[value / 2] = 1;
+}
+
+TEST(TreeWalkInOrderTest, Count) {
+  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+
+  struct tree t;
+  tree_create(&t);
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    tree_insert(&t, origin[i]);
+  }
+
+  int count[10];
+
+  std::memset(count, 0, sizeof count);
+  tree_walk_in_order(&t, check_once, count);
+
+  EXPECT_EQ(count[0], 0);
+
+  for (std::size_t i = 1; i < std::size(count); ++i) {
+    EXPECT_EQ(count[i], 1);
+  }
+
+  tree_destroy(&t);
+}
+
+/*
+ * tree_walk_pre_order
+ */
+
+TEST(TreeWalkPreOrderTest, Count) {
+  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+
+  struct tree t;
+  tree_create(&t);
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    tree_insert(&t, origin[i]);
+  }
+
+  int count[10];
+
+  std::memset(count, 0, sizeof count);
+  tree_walk_pre_order(&t, check_once, count);
+
+  EXPECT_EQ(count[0], 0);
+
+  for (std::size_t i = 1; i < std::size(count); ++i) {
+    EXPECT_EQ(count[i], 1);
+  }
+
+  tree_destroy(&t);
+}
+
+/*
+ * tree_walk_post_order
+ */
+
+TEST(TreeWalkPostOrderTest, Count) {
+  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+
+  struct tree t;
+  tree_create(&t);
+
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    tree_insert(&t, origin[i]);
+  }
+
+  int count[10];
+
+  std::memset(count, 0, sizeof count);
+  tree_walk_post_order(&t, check_once, count);
+
+  EXPECT_EQ(count[0], 0);
+
+  for (std::size_t i = 1; i < std::size(count); ++i) {
+    EXPECT_EQ(count[i], 1);
+  }
+
+  tree_destroy(&t);
+}
+
+/*
+ * btree_create
+ */
+
+TEST(BtreeCreateTest, Empty) {
+  struct btree t;
+  btree_create(&t);
+
+  EXPECT_TRUE(btree_empty(&t));
+  EXPECT_EQ(btree_size(&t), 0u);
+  EXPECT_EQ(btree_height(&t), 0u);
+  EXPECT_FALSE(btree_contains(&t, 0));
+  EXPECT_FALSE(btree_remove(&t, 0));
+
+  btree_destroy(&t);
+}
+
+TEST(BtreeCreateTest, NodeSize) {
+  EXPECT_EQ(offsetof(struct btree_node, children), static_cast<std::size_t>(BTREE_NODE_SIZE));
+  EXPECT_GE(BTREE_NODE_SIZE, 64);
+  EXPECT_LE(BTREE_NODE_SIZE, 256);
+}
+
+/*
+ * btree_insert
+ */
+
+// Check the ordering and the node fill, and return the depth of the leaves
+static std::size_t check_btree(const struct btree_node *node, bool root, long low, long high) {
+  if (!root) {
+    EXPECT_GE(node->count, BTREE_MIN_DEGREE - 1);
+  }
+
+  EXPECT_GE(node->count, 1);
+  EXPECT_LE(node->count, BTREE_MAX_KEYS);
+
+  for (std::size_t i = 0; i < node->count; ++i) {
+    EXPECT_LT(i == 0 ? low : node->keys[i - 1], node->keys[i]);
+  }
+
+  EXPECT_LT(node->keys[node->count - 1], high);
+
+  if (node->leaf) {
+    return 1;
+  }
+
+  std::size_t depth = check_btree(node->children[0], false, low, node->keys[0]);
+
+  for (std::size_t i = 1; i <= node->count; ++i) {
+    std::size_t other = check_btree(node->children[i], false, node->keys[i - 1], i == node->count ? high : node->keys[i]);
+    EXPECT_EQ(depth, other);
+  }
+
+  return depth + 1;
+}
 
-  std::size_t half = std::size(origin) / 2;
+static void check_btree(const struct btree *t) {
+  if (t->root != nullptr) {
+    EXPECT_EQ(check_btree(t->root, true, static_cast<long>(INT_MIN) - 1, static_cast<long>(INT_MAX) + 1), btree_height(t));
+  }
+}
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+TEST(BtreeInsertTest, AlreadyPresent) {
+  struct btree t;
+  btree_create(&t);
 
-  struct list l1;
-  list_create(&l1);
+  EXPECT_TRUE(btree_insert(&t, 5));
+  EXPECT_TRUE(btree_insert(&t, 7));
+  EXPECT_FALSE(btree_insert(&t, 7));
 
-  struct list l2;
-  list_create(&l2);
+  EXPECT_EQ(btree_size(&t), 2u);
+  EXPECT_EQ(btree_height(&t), 1u);
+  EXPECT_TRUE(btree_contains(&t, 5));
+  EXPECT_TRUE(btree_contains(&t, 7));
+  EXPECT_FALSE(btree_contains(&t, 6));
 
-  list_split(&l, &l1, &l2);
+  btree_destroy(&t);
+}
 
-  EXPECT_TRUE(list_empty(&l));
-  EXPECT_EQ(list_size(&l1), half);
-  EXPECT_EQ(list_size(&l2), half);
+TEST(BtreeInsertTest, SortedKeys) {
+  static const int size = 100 * BIG_SIZE;
 
-  for (auto val : origin) {
-    EXPECT_TRUE(list_search(&l1, val) != half || list_search(&l2, val) != half);
+  struct btree t;
+  btree_create(&t);
+
+  for (int i = 0; i < size; ++i) {
+    EXPECT_TRUE(btree_insert(&t, i));
   }
 
-  list_destroy(&l2);
-  list_destroy(&l1);
-  list_destroy(&l);
-}
+  for (int i = 0; i < size; ++i) {
+    EXPECT_FALSE(btree_insert(&t, i));
+  }
 
+  EXPECT_EQ(btree_size(&t), static_cast<std::size_t>(size));
+  EXPECT_LE(btree_height(&t), 5u);
+  check_btree(&t);
 
-TEST(ListSplitTest, OddSize) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
-  assert(std::size(origin) % 2 == 1);
+  for (int i = 0; i < size; ++i) {
+    EXPECT_TRUE(btree_contains(&t, i));
+  }
 
-  std::size_t half = std::size(origin) / 2;
+  EXPECT_FALSE(btree_contains(&t, -1));
+  EXPECT_FALSE(btree_contains(&t, size));
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  btree_destroy(&t);
+}
 
-  struct list l1;
-  list_create(&l1);
+TEST(BtreeInsertTest, Stressed) {
+  struct btree t;
+  btree_create(&t);
 
-  struct list l2;
-  list_create(&l2);
+  std::vector<int> reference;
+  std::srand(0);
 
-  list_split(&l, &l1, &l2);
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    int value = std::rand() - RAND_MAX / 2;
+    bool present = std::find(reference.begin(), reference.end(), value) != reference.end();
 
-  std::size_t sz1 = list_size(&l1);
-  std::size_t sz2 = list_size(&l2);
+    EXPECT_EQ(btree_insert(&t, value), !present);
 
-  EXPECT_TRUE(list_empty(&l));
-  EXPECT_EQ(sz1 + sz2, std::size(origin));
+    if (!present) {
+      reference.push_back(value);
+    }
+  }
 
-  EXPECT_TRUE((sz1 == half && sz2 == half + 1) || (sz1 == half + 1 && sz2 == half));
+  EXPECT_EQ(btree_size(&t), reference.size());
+  check_btree(&t);
 
-  for (auto val : origin) {
-    EXPECT_TRUE(list_search(&l1, val) != sz1 || list_search(&l2, val) != sz2);
+  for (int value : reference) {
+    EXPECT_TRUE(btree_contains(&t, value));
   }
 
-  list_destroy(&l2);
-  list_destroy(&l1);
-  list_destroy(&l);
+  btree_destroy(&t);
 }
 
 /*
- * list_merge
+ * btree_remove
  */
 
-TEST(ListMergeTest, BothNonEmpty) {
-  static const int origin1[] = { 0, 1, 3, 6, 10 };
-  static const int origin2[] = { 2, 4, 5, 7, 8, 9 };
-  static const int expected[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
-
-  struct list l;
-  list_create(&l);
+TEST(BtreeRemoveTest, Stressed) {
+  struct btree t;
+  btree_create(&t);
 
-  struct list l1;
-  list_create_from(&l1, origin1, std::size(origin1));
+  std::vector<bool> present(8 * BIG_SIZE, false);
+  std::size_t expected = 0;
+  std::srand(0);
 
-  struct list l2;
-  list_create_from(&l2, origin2, std::size(origin2));
+  for (int round = 0; round < 10; ++round) {
+    for (int i = 0; i < 2 * BIG_SIZE; ++i) {
+      int value = std::rand() % (8 * BIG_SIZE);
 
-  list_merge(&l, &l1, &l2);
+      EXPECT_EQ(btree_insert(&t, value), !present[value]);
 
-  EXPECT_TRUE(list_empty(&l1));
-  EXPECT_TRUE(list_empty(&l2));
-  EXPECT_EQ(list_size(&l), std::size(expected));
-  EXPECT_TRUE(list_equals(&l, expected, std::size(expected)));
+      if (!present[value]) {
+        present[value] = true;
+        ++expected;
+      }
+    }
 
-  list_destroy(&l2);
-  list_destroy(&l1);
-  list_destroy(&l);
-}
+    for (int i = 0; i < 2 * BIG_SIZE; ++i) {
+      int value = std::rand() % (8 * BIG_SIZE);
 
-TEST(ListMergeTest, FirstEmpty) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+      EXPECT_EQ(btree_remove(&t, value), present[value]);
 
-  struct list l;
-  list_create(&l);
+      if (present[value]) {
+        present[value] = false;
+        --expected;
+      }
 
-  struct list l1;
-  list_create(&l1);
+      EXPECT_FALSE(btree_contains(&t, value));
+    }
 
-  struct list l2;
-  list_create_from(&l2, origin, std::size(origin));
+    EXPECT_EQ(btree_size(&t), expected);
+    check_btree(&t);
+  }
 
-  list_merge(&l, &l1, &l2);
+  for (int value = 0; value < 8 * BIG_SIZE; ++value) {
+    EXPECT_EQ(btree_remove(&t, value), present[value]);
+  }
 
-  EXPECT_TRUE(list_empty(&l1));
-  EXPECT_TRUE(list_empty(&l2));
-  EXPECT_EQ(list_size(&l), std::size(origin));
-  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
+  EXPECT_TRUE(btree_empty(&t));
+  EXPECT_EQ(btree_height(&t), 0u);
 
-  list_destroy(&l2);
-  list_destroy(&l1);
-  list_destroy(&l);
+  btree_destroy(&t);
 }
 
-TEST(ListMergeTest, SecondEmpty) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+TEST(BtreeRemoveTest, SortedKeys) {
+  static const int size = 10 * BIG_SIZE;
 
-  struct list l;
-  list_create(&l);
+  struct btree t;
+  btree_create(&t);
 
-  struct list l1;
-  list_create_from(&l1, origin, std::size(origin));
+  for (int i = 0; i < size; ++i) {
+    btree_insert(&t, i);
+  }
 
-  struct list l2;
-  list_create(&l2);
+  for (int i = 0; i < size; i += 2) {
+    EXPECT_TRUE(btree_remove(&t, i));
+  }
 
-  list_merge(&l, &l1, &l2);
+  check_btree(&t);
 
-  EXPECT_TRUE(list_empty(&l1));
-  EXPECT_TRUE(list_empty(&l2));
-  EXPECT_EQ(list_size(&l), std::size(origin));
-  EXPECT_TRUE(list_equals(&l, origin, std::size(origin)));
+  for (int i = size - 1; i >= 0; i -= 2) {
+    EXPECT_TRUE(btree_remove(&t, i));
+  }
 
-  list_destroy(&l2);
-  list_destroy(&l1);
-  list_destroy(&l);
+  EXPECT_TRUE(btree_empty(&t));
+
+  btree_destroy(&t);
 }
 
 /*
- * list_merge_sort
+ * btree_walk_in_order, btree_walk_pre_order, btree_walk_post_order
  */
 
-TEST(ListMergeSortTest, NotSorted) {
-  static const int origin[] = { 8, 4, 1, 6, 10, 3, 0, 9, 5, 2, 7 };
-
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+TEST(BtreeWalkTest, InOrder) {
+  struct btree t;
+  btree_create(&t);
 
-  EXPECT_FALSE(list_is_sorted(&l));
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    btree_insert(&t, ((i * 7919) % BIG_SIZE) * 2 + 2);
+  }
 
-  list_merge_sort(&l);
+  int expected = 2;
+  btree_walk_in_order(&t, check_tree, &expected);
+  EXPECT_EQ(expected, 2 * BIG_SIZE + 2);
 
-  EXPECT_TRUE(list_is_sorted(&l));
-  EXPECT_EQ(list_size(&l), std::size(origin));
+  btree_destroy(&t);
+}
 
-  for (int val : origin) {
-    EXPECT_NE(list_search(&l, val), std::size(origin));
-  }
+TEST(BtreeWalkTest, Count) {
+  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
 
-  list_destroy(&l);
-}
+  struct btree t;
+  btree_create(&t);
 
-TEST(ListMergeSortTest, SortedBackward) {
-  static const int origin[] = { 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+  for (std::size_t i = 0; i < std::size(origin); ++i) {
+    btree_insert(&t, origin[i]);
+  }
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+  int count[10];
 
-  EXPECT_FALSE(list_is_sorted(&l));
+  std::memset(count, 0, sizeof count);
+  btree_walk_pre_order(&t, check_once, count);
 
-  list_merge_sort(&l);
+  for (std::size_t i = 1; i < std::size(count); ++i) {
+    EXPECT_EQ(count[i], 1);
+  }
 
-  EXPECT_TRUE(list_is_sorted(&l));
-  EXPECT_EQ(list_size(&l), std::size(origin));
+  std::memset(count, 0, sizeof count);
+  btree_walk_post_order(&t, check_once, count);
 
-  for (int val : origin) {
-    EXPECT_NE(list_search(&l, val), std::size(origin));
+  for (std::size_t i = 1; i < std::size(count); ++i) {
+    EXPECT_EQ(count[i], 1);
   }
 
-  list_destroy(&l);
+  btree_destroy(&t);
 }
 
-TEST(ListMergeSortTest, Sorted) {
-  static const int origin[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+/*
+ * tree_walk_pre_order, tree_walk_in_order, tree_walk_post_order
+ */
 
-  struct list l;
-  list_create_from(&l, origin, std::size(origin));
+static void collect_tree(int value, void *user_data) {
+  std::vector<int> *values = static_cast<std::vector<int> *>(user_data);
+  values->push_back(value);
+}
 
-  EXPECT_TRUE(list_is_sorted(&l));
+static void reference_pre_order(const struct tree_node *node, std::vector<int> &values) {
+  if (node != nullptr) {
+    values.push_back(node->data);
+    reference_pre_order(node->left, values);
+    reference_pre_order(node->right, values);
+  }
+}
 
-  list_merge_sort(&l);
+static void reference_post_order(const struct tree_node *node, std::vector<int> &values) {
+  if (node != nullptr) {
+    reference_post_order(node->left, values);
+    reference_post_order(node->right, values);
+    values.push_back(node->data);
+  }
+}
 
-  EXPECT_TRUE(list_is_sorted(&l));
-  EXPECT_EQ(list_size(&l), std::size(origin));
+TEST(TreeWalkTest, Orders) {
+  struct tree t;
+  tree_create(&t);
 
-  for (int val : origin) {
-    EXPECT_NE(list_search(&l, val), std::size(origin));
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    tree_insert(&t, (i * 7919) % BIG_SIZE);
   }
 
-  list_destroy(&l);
+  std::vector<int> values;
+  std::vector<int> expected;
+
+  tree_walk_pre_order(&t, collect_tree, &values);
+  reference_pre_order(t.root, expected);
+  EXPECT_EQ(values, expected);
+
+  values.clear();
+  expected.clear();
+  tree_walk_post_order(&t, collect_tree, &values);
+  reference_post_order(t.root, expected);
+  EXPECT_EQ(values, expected);
+
+  tree_destroy(&t);
 }
 
-/*
- * tree_create
- */
+TEST(TreeWalkTest, Large) {
+  static const int size = 1000 * BIG_SIZE;
 
-TEST(TreeCreateTest, Empty) {
   struct tree t;
-
   tree_create(&t);
 
-  EXPECT_TRUE(tree_empty(&t));
-  EXPECT_EQ(tree_size(&t), 0u);
-  EXPECT_EQ(tree_height(&t), 0u);
+  for (int i = 0; i < size; ++i) {
+    tree_insert(&t, i);
+  }
+
+  int expected = 0;
+  tree_walk_in_order(&t, [](int value, void *user_data) {
+    int *expected = static_cast<int *>(user_data);
+    EXPECT_EQ(value, *expected);
+    ++*expected;
+  }, &expected);
+  EXPECT_EQ(expected, size);
+
+  std::size_t count = 0;
+  auto counter = [](int, void *user_data) { ++*static_cast<std::size_t *>(user_data); };
+  tree_walk_pre_order(&t, counter, &count);
+  tree_walk_post_order(&t, counter, &count);
+  EXPECT_EQ(count, 2u * size);
 
   tree_destroy(&t);
+  EXPECT_TRUE(tree_empty(&t));
 }
 
+TEST(TreeWalkTest, Degenerate) {
+  static const int depth = 10 * BIG_SIZE;
 
-/*
- * tree_insert
- */
+  // A comb assembled by hand: a left spine far deeper than any balanced tree, each spine node
+  // carrying a right leaf, so that every walk has to stack the whole spine
+  std::vector<struct tree_node> nodes(2 * depth);
 
-TEST(TreeInsertTest, OneElement) {
-  struct tree t;
+  for (int k = 0; k < depth; ++k) {
+    struct tree_node *spine = &nodes[2 * k];
+    struct tree_node *leaf = &nodes[2 * k + 1];
+    *leaf = {2 * (depth - k) + 1, 0, false, nullptr, nullptr, 1};
+    *spine = {2 * (depth - k), 0, false, (k + 1 < depth) ? &nodes[2 * k + 2] : nullptr, leaf, static_cast<std::size_t>(2 * (depth - k))};
+  }
 
+  struct tree t;
   tree_create(&t);
-  bool inserted = tree_insert(&t, 0);
-
-  EXPECT_TRUE(inserted);
-  EXPECT_FALSE(tree_empty(&t));
-  EXPECT_EQ(tree_size(&t), 1u);
-  EXPECT_EQ(tree_height(&t), 1u);
-  EXPECT_TRUE(tree_contains(&t, 0));
+  t.root = &nodes[0];
+  t.size = nodes.size();
+
+  std::vector<int> values;
+  std::vector<int> expected;
+
+  tree_walk_pre_order(&t, collect_tree, &values);
+  reference_pre_order(t.root, expected);
+  EXPECT_EQ(values, expected);
+
+  values.clear();
+  expected.clear();
+  tree_walk_post_order(&t, collect_tree, &values);
+  reference_post_order(t.root, expected);
+  EXPECT_EQ(values, expected);
+
+  values.clear();
+  expected.clear();
+  tree_walk_in_order(&t, collect_tree, &values);
+  for (int value = 2; value <= 2 * depth + 1; ++value) {
+    expected.push_back(value);
+  }
+  EXPECT_EQ(values, expected);
 
+  t.root = nullptr;
+  t.size = 0;
   tree_destroy(&t);
 }
 
-TEST(TreeInsertTest, TwoElements) {
-  struct tree t;
+/*
+ * tree_walk_range
+ */
 
+TEST(TreeWalkRangeTest, Stressed) {
+  struct tree t;
   tree_create(&t);
-  bool inserted1 = tree_insert(&t, 1);
-  bool inserted2 = tree_insert(&t, 2);
 
-  EXPECT_TRUE(inserted1);
-  EXPECT_TRUE(inserted2);
-  EXPECT_FALSE(tree_empty(&t));
-  EXPECT_EQ(tree_size(&t), 2u);
-  EXPECT_EQ(tree_height(&t), 2u);
-  EXPECT_TRUE(tree_contains(&t, 1));
-  EXPECT_TRUE(tree_contains(&t, 2));
+  std::vector<int> reference;
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    int value = (i * 7919) % (3 * BIG_SIZE);
+
+    if (tree_insert(&t, value)) {
+      reference.push_back(value);
+    }
+  }
+
+  std::sort(reference.begin(), reference.end());
+
+  for (int lo = -5; lo < 3 * BIG_SIZE; lo += 101) {
+    for (int hi = lo - 1; hi < lo + 400; hi += 37) {
+      std::vector<int> values;
+      tree_walk_range(&t, lo, hi, collect_tree, &values);
+
+      std::vector<int> expected(std::lower_bound(reference.begin(), reference.end(), lo), std::upper_bound(reference.begin(), reference.end(), hi));
+
+      if (hi < lo) {
+        expected.clear();
+      }
+
+      EXPECT_EQ(values, expected);
+    }
+  }
 
   tree_destroy(&t);
 }
 
-TEST(TreeInsertTest, AlreadyPresent) {
+TEST(TreeWalkRangeTest, Limits) {
+  static const int origin[] = { INT_MIN, -1, 0, 1, INT_MAX };
+
   struct tree t;
   tree_create(&t);
 
-  bool inserted1 = tree_insert(&t, 5);
-
-  EXPECT_TRUE(inserted1);
-
-  bool inserted2 = tree_insert(&t, 7);
+  for (int value : origin) {
+    tree_insert(&t, value);
+  }
 
-  EXPECT_TRUE(inserted2);
+  std::vector<int> values;
+  tree_walk_range(&t, INT_MIN, INT_MAX, collect_tree, &values);
+  EXPECT_EQ(values, std::vector<int>(std::begin(origin), std::end(origin)));
 
-  bool inserted3 = tree_insert(&t, 7); // already present
+  values.clear();
+  tree_walk_range(&t, INT_MAX, INT_MAX, collect_tree, &values);
+  EXPECT_EQ(values, std::vector<int>{ INT_MAX });
 
-  EXPECT_FALSE(inserted3);
-  EXPECT_FALSE(tree_empty(&t));
-  EXPECT_EQ(tree_size(&t), 2u);
-  EXPECT_EQ(tree_height(&t), 2u);
-  EXPECT_TRUE(tree_contains(&t, 5));
-  EXPECT_TRUE(tree_contains(&t, 7));
+  values.clear();
+  tree_walk_range(&t, -1, 1, collect_tree, &values);
+  EXPECT_EQ(values, (std::vector<int>{ -1, 0, 1 }));
 
   tree_destroy(&t);
 }
 
+/*
+ * tree_visit_in_order, tree_visit_range
+ */
 
-TEST(TreeInsertTest, ManyElements) {
-  static const int values[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+static bool take_tree(int value, void *user_data) {
+  std::vector<int> *values = static_cast<std::vector<int> *>(user_data);
+  values->push_back(value);
+  return values->size() < 10;
+}
 
+TEST(TreeVisitTest, EarlyExit) {
   struct tree t;
   tree_create(&t);
 
-  for (std::size_t i = 0; i < std::size(values); ++i) {
-    bool inserted = tree_insert(&t, values[i]);
-    EXPECT_TRUE(inserted);
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    tree_insert(&t, i);
   }
 
-  for (std::size_t i = 0; i < std::size(values); ++i) {
-    EXPECT_TRUE(tree_contains(&t, values[i]));
-  }
+  std::vector<int> values;
+  EXPECT_FALSE(tree_visit_in_order(&t, take_tree, &values));
+  EXPECT_EQ(values, (std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }));
 
-  for (int i = 1; i <= 19; i += 2) {
-    EXPECT_FALSE(tree_contains(&t, i));
-  }
+  values.clear();
+  EXPECT_FALSE(tree_visit_range(&t, 500, BIG_SIZE, take_tree, &values));
+  EXPECT_EQ(values.size(), 10u);
+  EXPECT_EQ(values.front(), 500);
+  EXPECT_EQ(values.back(), 509);
+
+  values.clear();
+  EXPECT_TRUE(tree_visit_range(&t, BIG_SIZE - 5, 2 * BIG_SIZE, take_tree, &values));
+  EXPECT_EQ(values.size(), 5u);
 
   tree_destroy(&t);
 }
 
-static size_t log_2(size_t x) {
-  size_t res = 0;
-
-  while (x != 0) {
-    res++;
-    x /= 2;
-  }
-
-  return res;
-}
+/*
+ * tree_rank, tree_select
+ */
 
-TEST(TreeInsertTest, Stressed) {
+TEST(TreeRankSelectTest, Stressed) {
   struct tree t;
   tree_create(&t);
 
-  std::size_t expected = 0;
+  std::vector<int> reference;
   std::srand(0);
 
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    int value = std::rand();
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    int value = std::rand() % (20 * BIG_SIZE);
 
     if (tree_insert(&t, value)) {
-      ++expected;
+      reference.push_back(value);
     }
 
-    EXPECT_EQ(tree_size(&t), expected);
+    if (i % 3 == 0) {
+      int removed = std::rand() % (20 * BIG_SIZE);
+      auto it = std::find(reference.begin(), reference.end(), removed);
+      EXPECT_EQ(tree_remove(&t, removed), it != reference.end());
+
+      if (it != reference.end()) {
+        reference.erase(it);
+      }
+    }
   }
 
-  EXPECT_FALSE(tree_empty(&t));
+  std::sort(reference.begin(), reference.end());
+  ASSERT_EQ(tree_size(&t), reference.size());
+  check_balanced(&t);
 
-  size_t size = tree_size(&t);
-  size_t height = tree_height(&t);
+  for (std::size_t i = 0; i < reference.size(); ++i) {
+    EXPECT_EQ(tree_select(&t, i), reference[i]);
+    EXPECT_EQ(tree_rank(&t, reference[i]), i);
+  }
 
-  EXPECT_EQ(size, expected);
-  EXPECT_LE(height, size);
-  EXPECT_LE(log_2(size + 1), height);
+  for (int value = -1; value <= 20 * BIG_SIZE; value += 97) {
+    std::size_t expected = std::lower_bound(reference.begin(), reference.end(), value) - reference.begin();
+    EXPECT_EQ(tree_rank(&t, value), expected);
+  }
+
+  tree_destroy(&t);
+}
+
+TEST(TreeRankSelectTest, Empty) {
+  struct tree t;
+  tree_create(&t);
+
+  EXPECT_EQ(tree_rank(&t, 0), 0u);
+
+  tree_insert(&t, 5);
+
+  EXPECT_EQ(tree_rank(&t, 5), 0u);
+  EXPECT_EQ(tree_rank(&t, 6), 1u);
+  EXPECT_EQ(tree_select(&t, 0), 5);
 
   tree_destroy(&t);
 }
 
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
 /*
- * tree_remove
+ * tree_create_from_sorted, tree_create_from
  */
 
-TEST(TreeRemoveTest, ManyElements) {
-  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+TEST(TreeCreateFromSortedTest, Sizes) {
+  for (int size = 0; size <= 70; ++size) {
+    std::vector<int> origin;
 
-  struct tree t;
-  tree_create(&t);
+    for (int i = 0; i < size; ++i) {
+      origin.push_back(3 * i - size);
+    }
 
-  for (int val : origin) {
-    tree_insert(&t, val);
-  }
+    struct tree t;
+    tree_create_from_sorted(&t, origin.data(), origin.size());
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    EXPECT_TRUE(tree_contains(&t, origin[i]));
+    EXPECT_EQ(tree_size(&t), origin.size());
+    EXPECT_EQ(tree_height(&t), log_2(origin.size()));
+    check_balanced(&t);
 
-    bool removed = tree_remove(&t, origin[i]);
+    std::vector<int> values;
+    tree_walk_in_order(&t, collect_tree, &values);
+    EXPECT_EQ(values, origin);
 
-    EXPECT_TRUE(removed);
-    EXPECT_FALSE(tree_contains(&t, origin[i]));
-    EXPECT_EQ(tree_size(&t), std::size(origin) - i - 1);
+    tree_destroy(&t);
   }
+}
+
+TEST(TreeCreateFromSortedTest, Duplicates) {
+  static const int origin[] = { 1, 1, 2, 3, 3, 3, 4 };
+  static const int expected[] = { 1, 2, 3, 4 };
+
+  struct tree t;
+  tree_create_from_sorted(&t, origin, std::size(origin));
+
+  EXPECT_EQ(tree_size(&t), std::size(expected));
+  check_balanced(&t);
+
+  std::vector<int> values;
+  tree_walk_in_order(&t, collect_tree, &values);
+  EXPECT_EQ(values, std::vector<int>(std::begin(expected), std::end(expected)));
 
   tree_destroy(&t);
 }
 
-TEST(TreeRemoveTest, NotPresentBefore) {
-  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+TEST(TreeCreateFromSortedTest, ThenModified) {
+  std::vector<int> origin;
+
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    origin.push_back(2 * i);
+  }
 
   struct tree t;
-  tree_create(&t);
+  tree_create_from_sorted(&t, origin.data(), origin.size());
 
-  for (int val : origin) {
-    tree_insert(&t, val);
+  for (int i = 0; i < BIG_SIZE; ++i) {
+    EXPECT_TRUE(tree_insert(&t, 2 * i + 1));
   }
 
-  bool removed = tree_remove(&t, 1);
+  for (int i = 0; i < BIG_SIZE; i += 2) {
+    EXPECT_TRUE(tree_remove(&t, 2 * i));
+  }
 
-  EXPECT_FALSE(removed);
-  EXPECT_EQ(tree_size(&t), std::size(origin));
+  EXPECT_EQ(tree_size(&t), static_cast<std::size_t>(BIG_SIZE + BIG_SIZE / 2));
+  check_balanced(&t);
 
   tree_destroy(&t);
+  EXPECT_TRUE(tree_empty(&t));
 }
 
-TEST(TreeRemoveTest, NotPresentMiddle) {
-  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+TEST(TreeCreateFromTest, Unsorted) {
+  std::vector<int> origin;
+  std::srand(0);
+
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    origin.push_back(std::rand() % (5 * BIG_SIZE) - BIG_SIZE);
+  }
 
   struct tree t;
-  tree_create(&t);
+  tree_create_from(&t, origin.data(), origin.size());
 
-  for (int val : origin) {
-    tree_insert(&t, val);
-  }
+  std::sort(origin.begin(), origin.end());
+  origin.erase(std::unique(origin.begin(), origin.end()), origin.end());
 
-  bool removed = tree_remove(&t, 9);
+  EXPECT_EQ(tree_size(&t), origin.size());
+  check_balanced(&t);
 
-  EXPECT_FALSE(removed);
-  EXPECT_EQ(tree_size(&t), std::size(origin));
+  for (std::size_t i = 0; i < origin.size(); ++i) {
+    EXPECT_EQ(tree_select(&t, i), origin[i]);
+  }
 
   tree_destroy(&t);
 }
 
-TEST(TreeRemoveTest, NotPresentAfter) {
-  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+/*
+ * tree_union, tree_intersection, tree_difference
+ */
 
-  struct tree t;
-  tree_create(&t);
+typedef void (*tree_set_op_t)(struct tree *self, struct tree *in1, struct tree *in2, unsigned threads);
 
-  for (int val : origin) {
-    tree_insert(&t, val);
+static std::vector<int> random_set(std::size_t size, int range) {
+  std::vector<int> values;
+
+  for (std::size_t i = 0; i < size; ++i) {
+    values.push_back(std::rand() % range);
   }
 
-  bool removed = tree_remove(&t, 19);
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  return values;
+}
 
-  EXPECT_FALSE(removed);
-  EXPECT_EQ(tree_size(&t), std::size(origin));
+static void fill_tree(struct tree *t, const std::vector<int> &values) {
+  std::vector<int> shuffled = values;
+  for (std::size_t i = shuffled.size(); i > 1; --i) {
+    std::swap(shuffled[i - 1], shuffled[std::rand() % i]);
+  }
 
-  tree_destroy(&t);
+  for (int value : shuffled) {
+    EXPECT_TRUE(tree_insert(t, value));
+  }
 }
 
-TEST(TreeRemoveTest, Stressed) {
-  struct tree t;
+static void check_set_op(tree_set_op_t op, const std::vector<int> &lhs, const std::vector<int> &rhs, const std::vector<int> &expected, unsigned threads) {
+  struct tree in1, in2, t;
+  tree_create(&in1);
+  tree_create(&in2);
   tree_create(&t);
+  fill_tree(&in1, lhs);
+  fill_tree(&in2, rhs);
+
+  op(&t, &in1, &in2, threads);
+
+  EXPECT_TRUE(tree_empty(&in1));
+  EXPECT_TRUE(tree_empty(&in2));
+  EXPECT_EQ(tree_size(&t), expected.size());
+  check_balanced(&t);
+
+  std::vector<int> values;
+  tree_walk_in_order(&t, collect_tree, &values);
+  EXPECT_EQ(values, expected);
+
+  tree_destroy(&t);
+  tree_destroy(&in1);
+  tree_destroy(&in2);
+}
+
+static void check_set_ops(const std::vector<int> &lhs, const std::vector<int> &rhs, unsigned threads) {
+  std::vector<int> expected;
+  std::set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(expected));
+  check_set_op(tree_union, lhs, rhs, expected, threads);
+
+  expected.clear();
+  std::set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(expected));
+  check_set_op(tree_intersection, lhs, rhs, expected, threads);
 
+  expected.clear();
+  std::set_difference(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(expected));
+  check_set_op(tree_difference, lhs, rhs, expected, threads);
+}
+
+TEST(TreeSetOpTest, Empty) {
+  std::vector<int> empty;
+  std::vector<int> values = { 1, 2, 3, 5, 8, 13 };
+
+  check_set_ops(empty, empty, 1);
+  check_set_ops(values, empty, 1);
+  check_set_ops(empty, values, 1);
+  check_set_ops(values, values, 1);
+}
+
+TEST(TreeSetOpTest, Stressed) {
   std::srand(0);
 
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    int value = rand();
-    tree_insert(&t, value);
+  for (unsigned threads : { 1u, 4u }) {
+    std::vector<int> lhs = random_set(50 * BIG_SIZE, 100 * BIG_SIZE);
+    std::vector<int> rhs = random_set(50 * BIG_SIZE, 100 * BIG_SIZE);
+    check_set_ops(lhs, rhs, threads);
   }
+}
 
-  size_t expected = tree_size(&t);
-  EXPECT_TRUE(expected > 0);
+TEST(TreeSetOpTest, DifferentSizes) {
+  std::srand(0);
 
-  std::srand(0); // reinit
+  for (std::size_t size : { 1, 10, 100, 10 * BIG_SIZE }) {
+    std::vector<int> lhs = random_set(size, 20 * BIG_SIZE);
+    std::vector<int> rhs = random_set(10 * BIG_SIZE, 20 * BIG_SIZE);
+    check_set_ops(lhs, rhs, 4);
+    check_set_ops(rhs, lhs, 4);
+  }
+}
 
-  for (int i = 0; i < BIG_SIZE; ++i) {
-    int value = rand();
+TEST(TreeSetOpTest, BulkAndPool) {
+  std::srand(0);
+  std::vector<int> lhs = random_set(10 * BIG_SIZE, 20 * BIG_SIZE);
+  std::vector<int> rhs = random_set(10 * BIG_SIZE, 20 * BIG_SIZE);
 
-    bool present = tree_contains(&t, value);
+  std::vector<int> expected;
+  std::set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(expected));
 
-    if (present) {
-      --expected;
-    }
+  struct tree in1, in2, t;
+  tree_create_from_sorted(&in1, lhs.data(), lhs.size());
+  tree_create_from_sorted(&in2, rhs.data(), rhs.size());
+  tree_create(&t);
 
-    bool removed = tree_remove(&t, value);
+  tree_intersection(&t, &in1, &in2, 4);
 
-    EXPECT_EQ(present, removed);
-    EXPECT_EQ(tree_size(&t), expected);
+  EXPECT_TRUE(tree_empty(&in1));
+  EXPECT_TRUE(tree_empty(&in2));
+  EXPECT_EQ(tree_size(&t), expected.size());
+  check_balanced(&t);
+
+  for (int value : lhs) {
+    tree_remove(&t, value);
   }
 
-  EXPECT_EQ(tree_size(&t), 0u);
+  EXPECT_TRUE(tree_empty(&t));
+  tree_destroy(&t);
+  tree_destroy(&in1);
+  tree_destroy(&in2);
+
+  struct node_pool pool;
+  node_pool_create(&pool, sizeof(struct tree_node), false);
+  tree_create_with_pool(&in1, &pool);
+  tree_create_with_pool(&in2, &pool);
+  tree_create_with_pool(&t, &pool);
+  fill_tree(&in1, lhs);
+  fill_tree(&in2, rhs);
+
+  tree_difference(&t, &in1, &in2, 4);
+
+  expected.clear();
+  std::set_difference(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(expected));
+  EXPECT_EQ(tree_size(&t), expected.size());
+  EXPECT_EQ(pool.live, expected.size());
+  check_balanced(&t);
 
   tree_destroy(&t);
+  node_pool_destroy(&pool);
 }
 
 /*
- * tree_walk_in_order
+ * ctree
  */
 
-static void check_tree(int value, void *user_data) {
-  int *expected = static_cast<int *>(user_data);
+static bool check_sorted_ctree(const struct ctree *t, std::vector<int> &values) {
+  values.clear();
+  ctree_walk_in_order(t, collect_tree, &values);
+  return std::adjacent_find(values.begin(), values.end(), std::greater_equal<int>()) == values.end();
+}
 
-  ASSERT_TRUE(expected != NULL);
-  EXPECT_EQ(*expected, value);
+TEST(CtreeTest, Empty) {
+  struct ctree t;
+  ctree_create(&t);
 
-  (*expected) += 2;
+  EXPECT_TRUE(ctree_empty(&t));
+  EXPECT_EQ(ctree_size(&t), 0u);
+  EXPECT_FALSE(ctree_contains(&t, 0));
+  EXPECT_FALSE(ctree_remove(&t, 0));
+
+  ctree_destroy(&t);
 }
 
-TEST(TreeWalkInOrderTest, Ordered) {
-  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+TEST(CtreeTest, InsertRemove) {
+  struct ctree t;
+  ctree_create(&t);
 
-  struct tree t;
-  tree_create(&t);
+  static const int origin[] = { 0, -1, 1, INT_MIN, INT_MAX, 42, -42, 1 << 26, (1 << 26) - 1 };
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    tree_insert(&t, origin[i]);
+  for (int value : origin) {
+    EXPECT_TRUE(ctree_insert(&t, value));
+    EXPECT_FALSE(ctree_insert(&t, value));
   }
 
-  EXPECT_EQ(tree_size(&t), std::size(origin));
-
-  int expected = 2;
-  tree_walk_in_order(&t, check_tree, &expected);
-  EXPECT_EQ(expected, 20);
-
-  tree_destroy(&t);
-}
+  EXPECT_EQ(ctree_size(&t), std::size(origin));
 
-static void check_once(int value, void *user_data) {
-  int *count = static_cast<int *>(user_data);
+  std::vector<int> values;
+  EXPECT_TRUE(check_sorted_ctree(&t, values));
+  std::vector<int> expected(std::begin(origin), std::end(origin));
+  std::sort(expected.begin(), expected.end());
+  EXPECT_EQ(values, expected);
 
-  ASSERT_TRUE(count != NULL);
-  ASSERT_TRUE(2 <= value && value <= 18);
-  EXPECT_EQ(count[value / 2], 0);
+  for (int value : origin) {
+    EXPECT_TRUE(ctree_contains(&t, value));
+    EXPECT_TRUE(ctree_remove(&t, value));
+    EXPECT_FALSE(ctree_contains(&t, value));
+    EXPECT_FALSE(ctree_remove(&t, value));
+  }
 
-  count[value / 2] = 1;
+  EXPECT_TRUE(ctree_empty(&t));
+  ctree_destroy(&t);
 }
 
-TEST(TreeWalkInOrderTest, Count) {
-  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+TEST(CtreeTest, Stressed) {
+  struct ctree t;
+  ctree_create(&t);
 
-  struct tree t;
-  tree_create(&t);
+  std::vector<int> expected;
+  std::srand(0);
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    tree_insert(&t, origin[i]);
+  for (int i = 0; i < 10 * BIG_SIZE; ++i) {
+    int value = std::rand() % (4 * BIG_SIZE) - 2 * BIG_SIZE;
+    auto it = std::lower_bound(expected.begin(), expected.end(), value);
+    bool present = (it != expected.end() && *it == value);
+
+    if (std::rand() % 2 == 0) {
+      EXPECT_EQ(ctree_insert(&t, value), !present);
+      if (!present) {
+        expected.insert(it, value);
+      }
+    } else {
+      EXPECT_EQ(ctree_remove(&t, value), present);
+      if (present) {
+        expected.erase(it);
+      }
+    }
   }
 
-  int count[10];
+  EXPECT_EQ(ctree_size(&t), expected.size());
 
-  std::memset(count, 0, sizeof count);
-  tree_walk_in_order(&t, check_once, count);
+  std::vector<int> values;
+  EXPECT_TRUE(check_sorted_ctree(&t, values));
+  EXPECT_EQ(values, expected);
 
-  EXPECT_EQ(count[0], 0);
+  ctree_destroy(&t);
+}
 
-  for (std::size_t i = 1; i < std::size(count); ++i) {
-    EXPECT_EQ(count[i], 1);
+static void find_in_ctree(int value, void *user_data) {
+  const struct ctree *t = static_cast<const struct ctree *>(user_data);
+  EXPECT_TRUE(ctree_contains(t, value));
+}
+
+TEST(CtreeTest, NestedWalk) {
+  struct ctree t;
+  ctree_create(&t);
+
+  for (int i = -BIG_SIZE; i < BIG_SIZE; i += 7) {
+    ctree_insert(&t, i);
   }
 
-  tree_destroy(&t);
+  ctree_walk_in_order(&t, find_in_ctree, &t);
+
+  ctree_destroy(&t);
 }
 
 /*
- * tree_walk_pre_order
+ * Les écrivains se partagent les valeurs impaires et les changent sans arrêt, les valeurs paires
+ * sont insérées avant et ne bougent pas : les lecteurs doivent toujours les trouver.
  */
+TEST(CtreeTest, Concurrent) {
+  static const int writers = 4;
+  static const int readers = 8;
+  static const int range = 20 * BIG_SIZE;
 
-TEST(TreeWalkPreOrderTest, Count) {
-  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+  struct ctree t;
+  ctree_create(&t);
 
-  struct tree t;
-  tree_create(&t);
+  for (int i = -range; i < range; i += 2) {
+    EXPECT_TRUE(ctree_insert(&t, i));
+  }
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    tree_insert(&t, origin[i]);
+  std::atomic<bool> stop(false);
+  std::vector<std::vector<int>> owned(writers);
+  std::vector<std::thread> threads;
+
+  for (int w = 0; w < writers; ++w) {
+    threads.emplace_back([&t, &owned, w]() {
+      std::vector<bool> present(range, false);
+      unsigned seed = w;
+
+      for (int i = 0; i < 20 * BIG_SIZE; ++i) {
+        int slot = rand_r(&seed) % (range / writers);
+        int index = slot * writers + w;
+        int value = 2 * index - range + 1;
+
+        if (present[index]) {
+          EXPECT_TRUE(ctree_remove(&t, value));
+        } else {
+          EXPECT_TRUE(ctree_insert(&t, value));
+        }
+
+        present[index] = !present[index];
+      }
+
+      for (int index = w; index < range; index += writers) {
+        if (present[index]) {
+          owned[w].push_back(2 * index - range + 1);
+        }
+      }
+    });
   }
 
-  int count[10];
+  for (int r = 0; r < readers; ++r) {
+    threads.emplace_back([&t, &stop, r]() {
+      unsigned seed = writers + r;
+      std::vector<int> values;
+
+      do {
+        for (int i = 0; i < BIG_SIZE; ++i) {
+          int value = 2 * (rand_r(&seed) % range) - range;
+          EXPECT_TRUE(ctree_contains(&t, value));
+          EXPECT_FALSE(ctree_contains(&t, (value < 0) ? -range - 1 : range + 1));
+        }
+
+        EXPECT_TRUE(check_sorted_ctree(&t, values));
+        EXPECT_LE(static_cast<std::size_t>(range), values.size());
+      } while (!stop.load());
+    });
+  }
 
-  std::memset(count, 0, sizeof count);
-  tree_walk_pre_order(&t, check_once, count);
+  for (int w = 0; w < writers; ++w) {
+    threads[w].join();
+  }
 
-  EXPECT_EQ(count[0], 0);
+  stop.store(true);
 
-  for (std::size_t i = 1; i < std::size(count); ++i) {
-    EXPECT_EQ(count[i], 1);
+  for (std::size_t i = writers; i < threads.size(); ++i) {
+    threads[i].join();
   }
 
-  tree_destroy(&t);
+  std::vector<int> expected;
+
+  for (int i = -range; i < range; i += 2) {
+    expected.push_back(i);
+  }
+
+  for (const std::vector<int> &values : owned) {
+    expected.insert(expected.end(), values.begin(), values.end());
+  }
+
+  std::sort(expected.begin(), expected.end());
+
+  std::vector<int> values;
+  EXPECT_TRUE(check_sorted_ctree(&t, values));
+  EXPECT_EQ(values, expected);
+  EXPECT_EQ(ctree_size(&t), expected.size());
+
+  ctree_destroy(&t);
 }
 
 /*
- * tree_walk_post_order
+ * Chaque écrivain insère puis retire des valeurs consécutives dans son propre intervalle
  */
+TEST(CtreeTest, ConcurrentDenseRanges) {
+  static const int writers = 8;
+  static const int readers = 4;
+  static const int range = 5 * BIG_SIZE;
+
+  struct ctree t;
+  ctree_create(&t);
+
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> threads;
+
+  for (int w = 0; w < writers; ++w) {
+    threads.emplace_back([&t, w]() {
+      int first = w * range;
+
+      for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < range; ++i) {
+          EXPECT_TRUE(ctree_insert(&t, first + i));
+        }
+
+        for (int i = 0; i < range; ++i) {
+          EXPECT_TRUE(ctree_contains(&t, first + i));
+          EXPECT_TRUE(ctree_remove(&t, first + i));
+        }
+      }
+
+      for (int i = 0; i < range; i += 3) {
+        EXPECT_TRUE(ctree_insert(&t, first + i));
+      }
+    });
+  }
 
-TEST(TreeWalkPostOrderTest, Count) {
-  static const int origin[] = { 16, 2, 8, 4, 10, 18, 6, 12, 14 };
+  for (int r = 0; r < readers; ++r) {
+    threads.emplace_back([&t, &stop]() {
+      std::vector<int> values;
 
-  struct tree t;
-  tree_create(&t);
+      do {
+        EXPECT_TRUE(check_sorted_ctree(&t, values));
+        EXPECT_FALSE(ctree_contains(&t, -1));
+        EXPECT_FALSE(ctree_contains(&t, writers * range));
+      } while (!stop.load());
+    });
+  }
 
-  for (std::size_t i = 0; i < std::size(origin); ++i) {
-    tree_insert(&t, origin[i]);
+  for (int w = 0; w < writers; ++w) {
+    threads[w].join();
   }
 
-  int count[10];
+  stop.store(true);
 
-  std::memset(count, 0, sizeof count);
-  tree_walk_post_order(&t, check_once, count);
+  for (std::size_t i = writers; i < threads.size(); ++i) {
+    threads[i].join();
+  }
 
-  EXPECT_EQ(count[0], 0);
+  std::vector<int> expected;
 
-  for (std::size_t i = 1; i < std::size(count); ++i) {
-    EXPECT_EQ(count[i], 1);
+  for (int w = 0; w < writers; ++w) {
+    for (int i = 0; i < range; i += 3) {
+      expected.push_back(w * range + i);
+    }
   }
 
-  tree_destroy(&t);
-}
+  std::vector<int> values;
+  EXPECT_TRUE(check_sorted_ctree(&t, values));
+  EXPECT_EQ(values, expected);
+  EXPECT_EQ(ctree_size(&t), expected.size());
 
-int main(int argc, char *argv[]) {
-  ::testing::InitGoogleTest(&argc, argv);
-  return RUN_ALL_TESTS();
+  ctree_destroy(&t);
 }